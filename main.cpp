@@ -4,9 +4,37 @@
 #include <string>
 #include <memory>
 #include <utility>
+#include <vector>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+#include <string_view>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <iterator>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <tuple>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #define DEBUG_MESSAGES 0
 #define RUN_TESTS 0
+#define RUN_BENCHMARKS 0
+#define BENCHMARK_MAX_SIZE 100000000
+#define BENCHMARK_TIME_LIMIT 60
 
 #if DEBUG_MESSAGES == 1
 #define DEBUG(msg) std::cout << "[DEBUG] " << msg << std::endl
@@ -25,7 +53,7 @@
  * at the moment only contains key as
  * the value was not necessary for the task.
  */
-template<typename T>
+template<typename T, bool HasParent = true>
 struct Node
 {
 	/**
@@ -48,7 +76,17 @@ struct Node
 	 * Param: Key of this node.
 	 */
 	Node(T k)
-		: key{k}, parent{},
+		: key{std::move(k)}, parent{},
+		  left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
+	 */
+	template<typename... Args>
+	Node(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), parent{},
 		  left{}, right{}
 	{ /* DUMMY BODY */ }
 
@@ -69,929 +107,9896 @@ struct Node
 };
 
 /**
- * Auxiliary namespace containing functions used
- * for better code readability.
+ * Node layout used by top-down splay policies, these
+ * never walk back up the tree so the parent pointer
+ * is left out.
  */
-namespace utils
+template<typename T>
+struct Node<T, false>
 {
 	/**
-	 * Returns true if a given node is the left
-	 * son of its parent.
+	 * Key identifying this node.
 	 */
-	template<typename T>
-	bool is_left_son(Node<T>* node)
-	{
-		return node->parent->left == node;
-	}
+	T key;
 
 	/**
-	 * Returns true if a given node is a child of
-	 * a node that is the left son of its parent
-	 * node.
+	 * Default constructor.
 	 */
-	template<typename T>
-	bool is_son_of_left_son(Node<T>* node)
-	{
-		return node->parent->parent->left == node->parent;
-	}
+	Node() = default;
 
 	/**
-	 * Returns true if a given node is the right
-	 * son of its parent.
+	 * Destructor.
 	 */
-	template<typename T>
-	bool is_right_son(Node<T>* node)
-	{
-		return node->parent->right == node;
-	}
+	~Node() = default;
 
 	/**
-	 * Returns true if a given node is a child of a
-	 * node that is the right son of its parent node.
+	 * Constructor.
+	 * Param: Key of this node.
 	 */
-	template<typename T>
-	bool is_son_of_right_son(Node<T>* node)
-	{
-		return node->parent->parent->right == node->parent;
-	}
+	Node(T k)
+		: key{std::move(k)}, left{}, right{}
+	{ /* DUMMY BODY */ }
 
 	/**
-	 * Returns true if a given node is the left son of its
-	 * parent node and that node is the left son of its
-	 * parent node.
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
 	 */
-	template<typename T>
-	bool is_left_son_of_left_son(Node<T>* node)
-	{
-		return is_left_son(node) && is_son_of_left_son(node);
-	}
+	template<typename... Args>
+	Node(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), left{}, right{}
+	{ /* DUMMY BODY */ }
 
 	/**
-	 * Returns true if a given node is the right son of its
-	 * parent node and that node is the right son of its
-	 * parent node.
+	 * Pointer to the left child node.
 	 */
-	template<typename T>
-	bool is_right_son_of_right_son(Node<T>* node)
-	{
-		return is_right_son(node) && is_son_of_right_son(node);
-	}
+	Node<T, false>* left;
 
 	/**
-	 * Returns true if the father of a given node is the
-	 * root of the splay tree.
+	 * Pointer to the right child node.
 	 */
-	template<typename T>
-	bool is_son_of_root(Node<T>* node)
-	{
-		return node->parent && !node->parent->parent;
-	}
+	Node<T, false>* right;
+};
 
+/**
+ * Node template used by maps, contains a value
+ * along with the key.
+ */
+template<typename K, typename V, bool HasParent = true>
+struct MapNode
+{
 	/**
-	 * Returns true if a given node is the right son of its
-	 * parent node and that node is the left son of its
-	 * parent node.
+	 * Key identifying this node.
 	 */
-	template<typename T>
-	bool is_right_son_of_left_son(Node<T>* node)
-	{
-		return is_right_son(node) && is_son_of_left_son(node);
-	}
+	K key;
 
 	/**
-	 * Returns true if a given node is the left son of its
-	 * parent node and that node is the right son of its
-	 * parent node.
+	 * Value associated with the key.
 	 */
-	template<typename T>
-	bool is_left_son_of_right_son(Node<T>* node)
-	{
-		return is_left_son(node) && is_son_of_right_son(node);
-	}
+	V value;
 
 	/**
-	 * Auxiliary comparer, simple operator overloading could've
-	 * been used but I wanted to implement this more in the spirit
-	 * of the STL.
+	 * Constructor.
+	 * Param: Key of this node.
+	 * Param: Arguments passed to the constructor of the value.
 	 */
-	template<typename T>
-	struct SplayComparator
-	{
-		/**
-		 * Returns true if the key of a given node is less
-		 * than a given key.
-		 */
-		bool operator()(const Node<T>& a, const T& key) const
-		{
-			return a.key < key;
-		}
-	};
-}
+	template<typename... Args>
+	MapNode(const K& k, Args&&... args)
+		: key{k}, value(std::forward<Args>(args)...),
+		  parent{}, left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Pointer to the parent node.
+	 */
+	MapNode* parent;
+
+	/**
+	 * Pointer to the left child node.
+	 */
+	MapNode* left;
+
+	/**
+	 * Pointer to the right child node.
+	 */
+	MapNode* right;
+};
 
 /**
- * Class that represents a splay tree that contains keys of
- * a given type and uses a given splay policy.
+ * Map node layout used by top-down splay policies.
  */
-template<typename T, typename SplayPolicy, typename Comparator = utils::SplayComparator<T>>
-class SplayTree
+template<typename K, typename V>
+struct MapNode<K, V, false>
 {
-	friend bool test_3();
-	public:
-		/**
-		 * Constructor.
-		 */
-		SplayTree() = default;
-
-		/**
-		 * Destructor.
-		 */
-		~SplayTree()
-		{
-			if(root_)
-			{
-				delete_(root_);
-				delete root_;
-			}
-		}
+	/**
+	 * Key identifying this node.
+	 */
+	K key;
 
-		/**
-		 * Inserts the given key into the splay tree
-		 * if that key is not yet present in the tree.
-		 */
-		void insert(const T& key)
-		{
-			if(!root_)
-			{
-				root_ = new Node<T>{key};
-				return;
-			}
+	/**
+	 * Value associated with the key.
+	 */
+	V value;
 
-			auto closest = find_node_with_closest_key_(key);
-			
-			if(closest)
-			{ // Otherwise the key is already present.
-				SplayPolicy::splay(closest, &root_);
+	/**
+	 * Constructor.
+	 * Param: Key of this node.
+	 * Param: Arguments passed to the constructor of the value.
+	 */
+	template<typename... Args>
+	MapNode(const K& k, Args&&... args)
+		: key{k}, value(std::forward<Args>(args)...),
+		  left{}, right{}
+	{ /* DUMMY BODY */ }
 
-				if(closest->key == key)
-					return; // Already present.
+	/**
+	 * Pointer to the left child node.
+	 */
+	MapNode* left;
 
-				auto tmp = new Node<T>{key};
-				if(comparator_(*root_, key))
-				{
-					tmp->right = root_->right;
-					root_->right = tmp;
-					tmp->parent = root_;
+	/**
+	 * Pointer to the right child node.
+	 */
+	MapNode* right;
+};
 
-					if(tmp->right)
-						tmp->right->parent = tmp;
-				}
-				else
-				{
-					tmp->left = root_->left;
-					root_->left = tmp;
-					tmp->parent = root_;
-				
-					if(tmp->left)
-						tmp->left->parent = tmp;
-				}
-			}
-		}
+/**
+ * Binds a given type of values to MapNode, so that it
+ * can be used as the node template of SplayTree (see SplayMap).
+ */
+template<typename V>
+struct MapNodes
+{
+	/**
+	 * Node template with the value.
+	 */
+	template<typename K, bool HasParent>
+	using type = MapNode<K, V, HasParent>;
+};
 
-		/**
-		 * Returns true if this tree contains
-		 * this key already.
-		 */
-		bool contains(const T& key)
-		{
-			auto found_key = find(key);
-			return key == found_key;
-		}
+/**
+ * Node template of order statistic trees, keeps the number
+ * of nodes in its subtree along with the key.
+ */
+template<typename T, bool HasParent = true>
+struct SizedNode
+{
+	/**
+	 * Key identifying this node.
+	 */
+	T key;
 
-		/**
-		 * Returns the key of a node that has the given key.
-		 *
-		 * ...
-		 *
-		 * I know, I know, this was just used for the test,
-		 * normally it'd return the value.
-		 */
-		T find(const T& key)
-		{
-			static T NOT_FOUND{};
-			auto closest = find_node_with_closest_key_(key);
-			SplayPolicy::splay(closest, &root_);
+	/**
+	 * Constructor.
+	 * Param: Key of this node.
+	 */
+	SizedNode(T k)
+		: key{std::move(k)}, size{1}, parent{},
+		  left{}, right{}
+	{ /* DUMMY BODY */ }
 
-			if(root_ && root_->key == key)
-				return root_->key;
-			else
-				return NOT_FOUND;
-		}
+	/**
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
+	 */
+	template<typename... Args>
+	SizedNode(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), size{1}, parent{},
+		  left{}, right{}
+	{ /* DUMMY BODY */ }
 
-		/**
-		 * Returns true if the tree is a valid binary
-		 * search tree.
-		 */
-		bool validate() const
-		{
-			return validate_(root_);
-		}
+	/**
+	 * Number of nodes in the subtree of this node.
+	 */
+	std::size_t size;
 
-		/**
-		 * Prints an auxiliary string representation of
-		 * this tree.
-		 */
-		void print() const
-		{
-			DEBUG(print_(root_));
-		}
+	/**
+	 * Pointer to the parent node.
+	 */
+	SizedNode* parent;
 
-		/**
-		 * Returns the length of the last find traversal.
-		 */
-		std::size_t length_of_last_find() const
-		{
-			return find_length_;
-		}
+	/**
+	 * Pointer to the left child node.
+	 */
+	SizedNode* left;
 
-	private:
-		/**
-		 * Root node of the splay tree.
-		 */
-		Node<T>* root_;
+	/**
+	 * Pointer to the right child node.
+	 */
+	SizedNode* right;
+};
 
-		/**
-		 * Comparator used to navigate the tree on
-		 * insert/find.
-		 */
-		Comparator comparator_;
+/**
+ * Sized node layout used by top-down splay policies.
+ */
+template<typename T>
+struct SizedNode<T, false>
+{
+	/**
+	 * Key identifying this node.
+	 */
+	T key;
 
-		/**
-		 * Returns true if a given node and its two
-		 * subtrees are valid binary search tree.
-		 */
-		bool validate_(Node<T>* node) const
+	/**
+	 * Constructor.
+	 * Param: Key of this node.
+	 */
+	SizedNode(T k)
+		: key{std::move(k)}, size{1}, left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
+	 */
+	template<typename... Args>
+	SizedNode(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), size{1}, left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Number of nodes in the subtree of this node.
+	 */
+	std::size_t size;
+
+	/**
+	 * Pointer to the left child node.
+	 */
+	SizedNode* left;
+
+	/**
+	 * Pointer to the right child node.
+	 */
+	SizedNode* right;
+};
+
+/**
+ * Node template of sequences (see SplaySequence), the position of
+ * a node is given by the sizes of the subtrees. Lazy range operations
+ * are kept as tags, which are pushed down to the sons before they
+ * are accessed.
+ */
+template<typename T>
+struct SequenceNode
+{
+	/**
+	 * Value stored in this node.
+	 */
+	T value;
+
+	/**
+	 * Constructor.
+	 * Param: Value stored in this node.
+	 */
+	SequenceNode(T v)
+		: value{std::move(v)}, size{1}, added{}, adding{}, reversed{},
+		  parent{}, left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Number of nodes in the subtree of this node.
+	 */
+	std::size_t size;
+
+	/**
+	 * Value yet to be added to the nodes in the subtrees of
+	 * the sons, the value of this node already includes it.
+	 */
+	T added;
+
+	/**
+	 * True if added has to be pushed down to the sons.
+	 */
+	bool adding;
+
+	/**
+	 * True if the order of the subtree has to be reversed,
+	 * the sons of this node have not been swapped yet.
+	 */
+	bool reversed;
+
+	/**
+	 * Pointer to the parent node.
+	 */
+	SequenceNode* parent;
+
+	/**
+	 * Pointer to the left child node.
+	 */
+	SequenceNode* left;
+
+	/**
+	 * Pointer to the right child node.
+	 */
+	SequenceNode* right;
+};
+
+/**
+ * Node template of trees with subtree aggregates, keeps the aggregate
+ * of the keys in its subtree along with the key. A given aggregate
+ * defines the aggregated value type and three functions:
+ *   identity()    the aggregate of no keys
+ *   of(key)       the aggregate of a single key
+ *   combine(a, b) the aggregate of two adjacent ranges of keys
+ * combine has to be associative, but it does not have to be commutative.
+ */
+template<typename T, bool HasParent, typename Aggregate>
+struct AggregateNode
+{
+	/**
+	 * Aggregate the node keeps.
+	 */
+	using aggregate_type = Aggregate;
+
+	/**
+	 * Key identifying this node.
+	 */
+	T key;
+
+	/**
+	 * Constructor.
+	 * Param: Key of this node.
+	 */
+	AggregateNode(T k)
+		: key{std::move(k)}, aggregate{Aggregate::of(key)}, parent{},
+		  left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
+	 */
+	template<typename... Args>
+	AggregateNode(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), aggregate{Aggregate::of(key)}, parent{},
+		  left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Aggregate of the keys in the subtree of this node.
+	 */
+	typename Aggregate::value_type aggregate;
+
+	/**
+	 * Pointer to the parent node.
+	 */
+	AggregateNode* parent;
+
+	/**
+	 * Pointer to the left child node.
+	 */
+	AggregateNode* left;
+
+	/**
+	 * Pointer to the right child node.
+	 */
+	AggregateNode* right;
+};
+
+/**
+ * Aggregate node layout used by top-down splay policies.
+ */
+template<typename T, typename Aggregate>
+struct AggregateNode<T, false, Aggregate>
+{
+	/**
+	 * Aggregate the node keeps.
+	 */
+	using aggregate_type = Aggregate;
+
+	/**
+	 * Key identifying this node.
+	 */
+	T key;
+
+	/**
+	 * Constructor.
+	 * Param: Key of this node.
+	 */
+	AggregateNode(T k)
+		: key{std::move(k)}, aggregate{Aggregate::of(key)}, left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
+	 */
+	template<typename... Args>
+	AggregateNode(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), aggregate{Aggregate::of(key)}, left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Aggregate of the keys in the subtree of this node.
+	 */
+	typename Aggregate::value_type aggregate;
+
+	/**
+	 * Pointer to the left child node.
+	 */
+	AggregateNode* left;
+
+	/**
+	 * Pointer to the right child node.
+	 */
+	AggregateNode* right;
+};
+
+/**
+ * Binds a given aggregate to AggregateNode, so that it
+ * can be used as the node template of SplayTree.
+ */
+template<typename Aggregate>
+struct AggregateNodes
+{
+	/**
+	 * Node template with the aggregate.
+	 */
+	template<typename T, bool HasParent>
+	using type = AggregateNode<T, HasParent, Aggregate>;
+};
+
+/**
+ * Aggregate that sums the keys.
+ */
+template<typename T>
+struct SumAggregate
+{
+	/**
+	 * Type of the aggregated values.
+	 */
+	using value_type = T;
+
+	/**
+	 * Returns the aggregate of no keys.
+	 */
+	static value_type identity()
+	{
+		return value_type{};
+	}
+
+	/**
+	 * Returns the aggregate of a single key.
+	 */
+	static value_type of(const T& key)
+	{
+		return key;
+	}
+
+	/**
+	 * Returns the aggregate of two adjacent ranges of keys.
+	 */
+	static value_type combine(const value_type& a, const value_type& b)
+	{
+		return a + b;
+	}
+};
+
+/**
+ * Aggregate that keeps the minimal key.
+ */
+template<typename T>
+struct MinAggregate
+{
+	/**
+	 * Type of the aggregated values.
+	 */
+	using value_type = T;
+
+	/**
+	 * Returns the aggregate of no keys.
+	 */
+	static value_type identity()
+	{
+		return std::numeric_limits<T>::max();
+	}
+
+	/**
+	 * Returns the aggregate of a single key.
+	 */
+	static value_type of(const T& key)
+	{
+		return key;
+	}
+
+	/**
+	 * Returns the aggregate of two adjacent ranges of keys.
+	 */
+	static value_type combine(const value_type& a, const value_type& b)
+	{
+		return std::min(a, b);
+	}
+};
+
+/**
+ * Aggregate that keeps the maximal key.
+ */
+template<typename T>
+struct MaxAggregate
+{
+	/**
+	 * Type of the aggregated values.
+	 */
+	using value_type = T;
+
+	/**
+	 * Returns the aggregate of no keys.
+	 */
+	static value_type identity()
+	{
+		return std::numeric_limits<T>::lowest();
+	}
+
+	/**
+	 * Returns the aggregate of a single key.
+	 */
+	static value_type of(const T& key)
+	{
+		return key;
+	}
+
+	/**
+	 * Returns the aggregate of two adjacent ranges of keys.
+	 */
+	static value_type combine(const value_type& a, const value_type& b)
+	{
+		return std::max(a, b);
+	}
+};
+
+/**
+ * Node template of link-cut trees (see LinkCutTree), every node is
+ * a vertex of the represented forest. The parent pointer links the
+ * node only within the splay tree of its preferred path, so it is null
+ * at the root of that tree, which keeps the pointer to the parent of
+ * the topmost vertex of the path in path_parent instead. The aggregates
+ * of the subtree are kept in both orders, so that reversing the path
+ * of a subtree only swaps them.
+ */
+template<typename T, typename Aggregate>
+struct LinkCutNode
+{
+	/**
+	 * Aggregate the node keeps.
+	 */
+	using aggregate_type = Aggregate;
+
+	/**
+	 * Value of the vertex.
+	 */
+	T key;
+
+	/**
+	 * Constructor.
+	 * Param: Value of the vertex.
+	 */
+	LinkCutNode(T k)
+		: key{std::move(k)}, aggregate{Aggregate::of(key)},
+		  reverse_aggregate{aggregate}, reversed{}, path_parent{},
+		  parent{}, left{}, right{}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Aggregate of the values in the subtree of this node,
+	 * from the top of the path to its bottom.
+	 */
+	typename Aggregate::value_type aggregate;
+
+	/**
+	 * Aggregate of the values in the subtree of this node,
+	 * from the bottom of the path to its top.
+	 */
+	typename Aggregate::value_type reverse_aggregate;
+
+	/**
+	 * True if the order of the subtree has to be reversed, the
+	 * aggregates are already swapped, but the sons are not.
+	 */
+	bool reversed;
+
+	/**
+	 * Pointer to the parent of the topmost vertex of the path,
+	 * valid only at the root of the splay tree of the path.
+	 */
+	LinkCutNode* path_parent;
+
+	/**
+	 * Pointer to the parent node in the splay tree of the path.
+	 */
+	LinkCutNode* parent;
+
+	/**
+	 * Pointer to the left child node (towards the top of the path).
+	 */
+	LinkCutNode* left;
+
+	/**
+	 * Pointer to the right child node (towards the bottom of the path).
+	 */
+	LinkCutNode* right;
+};
+
+/**
+ * Node layout of compact trees, the nodes are stored in a single
+ * array and link to each other by 32-bit indices into it.
+ */
+template<typename T, bool HasParent = true>
+struct CompactNode
+{
+	/**
+	 * Index that refers to no node.
+	 */
+	static constexpr std::uint32_t none{std::numeric_limits<std::uint32_t>::max()};
+
+	/**
+	 * Key identifying this node.
+	 */
+	T key;
+
+	/**
+	 * Default constructor.
+	 */
+	CompactNode() = default;
+
+	/**
+	 * Destructor.
+	 */
+	~CompactNode() = default;
+
+	/**
+	 * Constructor.
+	 * Param: Key of this node.
+	 */
+	CompactNode(T k)
+		: key{std::move(k)}, parent{none},
+		  left{none}, right{none}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
+	 */
+	template<typename... Args>
+	CompactNode(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), parent{none},
+		  left{none}, right{none}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Index of the parent node.
+	 */
+	std::uint32_t parent;
+
+	/**
+	 * Index of the left child node.
+	 */
+	std::uint32_t left;
+
+	/**
+	 * Index of the right child node.
+	 */
+	std::uint32_t right;
+};
+
+/**
+ * Compact node layout used by top-down splay policies.
+ */
+template<typename T>
+struct CompactNode<T, false>
+{
+	/**
+	 * Index that refers to no node.
+	 */
+	static constexpr std::uint32_t none{std::numeric_limits<std::uint32_t>::max()};
+
+	/**
+	 * Key identifying this node.
+	 */
+	T key;
+
+	/**
+	 * Default constructor.
+	 */
+	CompactNode() = default;
+
+	/**
+	 * Destructor.
+	 */
+	~CompactNode() = default;
+
+	/**
+	 * Constructor.
+	 * Param: Key of this node.
+	 */
+	CompactNode(T k)
+		: key{std::move(k)}, left{none}, right{none}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Constructor that creates the key in place.
+	 * Param: Arguments passed to the constructor of the key.
+	 */
+	template<typename... Args>
+	CompactNode(std::in_place_t, Args&&... args)
+		: key(std::forward<Args>(args)...), left{none}, right{none}
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Index of the left child node.
+	 */
+	std::uint32_t left;
+
+	/**
+	 * Index of the right child node.
+	 */
+	std::uint32_t right;
+};
+
+/**
+ * Auxiliary namespace containing functions used
+ * for better code readability.
+ */
+namespace utils
+{
+	/**
+	 * Returns true if a given node of a given
+	 * storage is the left son of its parent.
+	 */
+	template<typename S>
+	bool is_left_son(S& storage, typename S::handle node)
+	{
+		return storage.left(storage.parent(node)) == node;
+	}
+
+	/**
+	 * Returns true if a given node is a child of
+	 * a node that is the left son of its parent
+	 * node.
+	 */
+	template<typename S>
+	bool is_son_of_left_son(S& storage, typename S::handle node)
+	{
+		auto parent = storage.parent(node);
+		return storage.left(storage.parent(parent)) == parent;
+	}
+
+	/**
+	 * Returns true if a given node of a given
+	 * storage is the right son of its parent.
+	 */
+	template<typename S>
+	bool is_right_son(S& storage, typename S::handle node)
+	{
+		return storage.right(storage.parent(node)) == node;
+	}
+
+	/**
+	 * Returns true if a given node is a child of a
+	 * node that is the right son of its parent node.
+	 */
+	template<typename S>
+	bool is_son_of_right_son(S& storage, typename S::handle node)
+	{
+		auto parent = storage.parent(node);
+		return storage.right(storage.parent(parent)) == parent;
+	}
+
+	/**
+	 * Returns true if a given node is the left son of its
+	 * parent node and that node is the left son of its
+	 * parent node.
+	 */
+	template<typename S>
+	bool is_left_son_of_left_son(S& storage, typename S::handle node)
+	{
+		return is_left_son(storage, node) && is_son_of_left_son(storage, node);
+	}
+
+	/**
+	 * Returns true if a given node is the right son of its
+	 * parent node and that node is the right son of its
+	 * parent node.
+	 */
+	template<typename S>
+	bool is_right_son_of_right_son(S& storage, typename S::handle node)
+	{
+		return is_right_son(storage, node) && is_son_of_right_son(storage, node);
+	}
+
+	/**
+	 * Returns true if the father of a given node is the
+	 * root of the splay tree.
+	 */
+	template<typename S>
+	bool is_son_of_root(S& storage, typename S::handle node)
+	{
+		return storage.parent(node) != S::null
+			&& storage.parent(storage.parent(node)) == S::null;
+	}
+
+	/**
+	 * Returns true if a given node is the right son of its
+	 * parent node and that node is the left son of its
+	 * parent node.
+	 */
+	template<typename S>
+	bool is_right_son_of_left_son(S& storage, typename S::handle node)
+	{
+		return is_right_son(storage, node) && is_son_of_left_son(storage, node);
+	}
+
+	/**
+	 * Returns true if a given node is the left son of its
+	 * parent node and that node is the right son of its
+	 * parent node.
+	 */
+	template<typename S>
+	bool is_left_son_of_right_son(S& storage, typename S::handle node)
+	{
+		return is_left_son(storage, node) && is_son_of_right_son(storage, node);
+	}
+
+	/**
+	 * Type trait that is true for node types that keep
+	 * a pointer to their parent.
+	 */
+	template<typename N, typename = void>
+	struct has_parent : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename N>
+	struct has_parent<N, std::void_t<decltype(std::declval<N&>().parent)>>
+		: std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Sets the parent of a given node (if any), does nothing
+	 * for nodes that do not keep a parent pointer.
+	 */
+	template<typename N>
+	void set_parent(N* node, [[maybe_unused]] N* parent)
+	{
+		if constexpr(has_parent<N>::value)
+		{
+			if(node)
+				node->parent = parent;
+		}
+	}
+
+	/**
+	 * Same as above for a given node of a given storage.
+	 */
+	template<typename S>
+	void set_parent([[maybe_unused]] S& storage, [[maybe_unused]] typename S::handle node,
+					[[maybe_unused]] typename S::handle parent)
+	{
+		if constexpr(has_parent<typename S::node_type>::value)
+		{
+			if(node != S::null)
+				storage.parent(node) = parent;
+		}
+	}
+
+	/**
+	 * Type trait that is true for nodes that keep the
+	 * size of their subtree (see SizedNode).
+	 */
+	template<typename N, typename = void>
+	struct has_size : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename N>
+	struct has_size<N, std::void_t<decltype(std::declval<N&>().size)>>
+		: std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Type trait that is true for types whose values
+	 * can be added to each other with +=.
+	 */
+	template<typename T, typename = void>
+	struct is_addable : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename T>
+	struct is_addable<T, std::void_t<decltype(std::declval<T&>() += std::declval<const T&>())>>
+		: std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Type trait that is true for nodes that keep the aggregate
+	 * of their subtree (see AggregateNode).
+	 */
+	template<typename N, typename = void>
+	struct has_aggregate : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename N>
+	struct has_aggregate<N, std::void_t<typename N::aggregate_type>>
+		: std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Type trait that is true for nodes that also keep the
+	 * aggregate of their subtree in reverse order (see LinkCutNode).
+	 */
+	template<typename N, typename = void>
+	struct has_reverse_aggregate : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename N>
+	struct has_reverse_aggregate<N, std::void_t<decltype(std::declval<N&>().reverse_aggregate)>>
+		: std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Type trait that is true for nodes that keep data
+	 * about their subtree, which has to be updated when
+	 * the tree changes.
+	 */
+	template<typename N>
+	struct is_augmented
+		: std::bool_constant<has_size<N>::value || has_aggregate<N>::value>
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Returns the number of nodes in the subtree of a given node
+	 * of a given storage, which has to keep the subtree sizes.
+	 */
+	template<typename S>
+	std::size_t subtree_size(S& storage, typename S::handle node)
+	{
+		return node == S::null ? std::size_t{} : storage.node(node).size;
+	}
+
+	/**
+	 * Recomputes the data a given node of a given storage keeps
+	 * about its subtree (if any) from its sons, has to be called
+	 * whenever the sons of the node change.
+	 */
+	template<typename S>
+	void update([[maybe_unused]] S& storage, [[maybe_unused]] typename S::handle node)
+	{
+		using N = typename S::node_type;
+		if constexpr(has_size<N>::value)
+		{
+			storage.node(node).size = 1 + subtree_size(storage, storage.left(node))
+									    + subtree_size(storage, storage.right(node));
+		}
+		else if constexpr(has_aggregate<N>::value)
+		{ // Keeps the order of the keys for non-commutative aggregates.
+			using A = typename N::aggregate_type;
+			auto& current = storage.node(node);
+			auto value = A::of(current.key);
+			if(storage.left(node) != S::null)
+				value = A::combine(storage.node(storage.left(node)).aggregate, value);
+			if(storage.right(node) != S::null)
+				value = A::combine(value, storage.node(storage.right(node)).aggregate);
+			current.aggregate = std::move(value);
+
+			if constexpr(has_reverse_aggregate<N>::value)
+			{
+				auto reverse = A::of(current.key);
+				if(storage.right(node) != S::null)
+					reverse = A::combine(storage.node(storage.right(node)).reverse_aggregate, reverse);
+				if(storage.left(node) != S::null)
+					reverse = A::combine(reverse, storage.node(storage.left(node)).reverse_aggregate);
+				current.reverse_aggregate = std::move(reverse);
+			}
+		}
+	}
+
+	/**
+	 * Same as above for nodes addressed by pointers,
+	 * null nodes are ignored.
+	 */
+	template<typename N>
+	void update([[maybe_unused]] N* node)
+	{
+		if constexpr(has_size<N>::value)
+		{
+			if(node)
+			{
+				node->size = 1 + (node->left ? node->left->size : 0)
+							   + (node->right ? node->right->size : 0);
+			}
+		}
+		else if constexpr(has_aggregate<N>::value)
+		{
+			if(node)
+			{
+				using A = typename N::aggregate_type;
+				auto value = A::of(node->key);
+				if(node->left)
+					value = A::combine(node->left->aggregate, value);
+				if(node->right)
+					value = A::combine(value, node->right->aggregate);
+				node->aggregate = std::move(value);
+
+				if constexpr(has_reverse_aggregate<N>::value)
+				{
+					auto reverse = A::of(node->key);
+					if(node->right)
+						reverse = A::combine(node->right->reverse_aggregate, reverse);
+					if(node->left)
+						reverse = A::combine(reverse, node->left->reverse_aggregate);
+					node->reverse_aggregate = std::move(reverse);
+				}
+			}
+		}
+	}
+
+	/**
+	 * State of splay policies that do not need any.
+	 */
+	struct NoSplayState
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Type trait that is true for splay policies that restructure
+	 * the tree only partially on lookups (e.g. SemiSplayPolicy). Such
+	 * policies define the type of the state every tree keeps for them
+	 * and provide an access function called after a lookup, while
+	 * the operations changing the tree still use the full splay.
+	 */
+	template<typename P, typename = void>
+	struct splays_partially : std::false_type
+	{
+		using state = NoSplayState;
+	};
+
+	template<typename P>
+	struct splays_partially<P, std::void_t<typename P::state>>
+		: std::true_type
+	{
+		using state = typename P::state;
+	};
+
+	/**
+	 * Returns the binary logarithm of a given number rounded
+	 * down (zero for zero).
+	 */
+	inline std::size_t floor_log2(std::size_t number)
+	{
+		std::size_t res{};
+		while(number >>= 1)
+			++res;
+
+		return res;
+	}
+
+	/**
+	 * Type trait that is true if keys of type A have a three-way
+	 * compare member function accepting keys of type B.
+	 */
+	template<typename A, typename B, typename = void>
+	struct has_compare : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename A, typename B>
+	struct has_compare<A, B, std::void_t<decltype(
+		static_cast<int>(std::declval<const A&>().compare(std::declval<const B&>()))
+	)>> : std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Compares two keys with a single three-way comparison where
+	 * possible, returns a negative number if the first key is less
+	 * than the second one, zero if they are equal and a positive
+	 * number otherwise. Keys that have a compare member function
+	 * (like std::string or ArenaString) are compared by it.
+	 */
+	template<typename A, typename B>
+	int three_way_compare(const A& a, const B& b)
+	{
+		if constexpr(std::is_arithmetic_v<A> && std::is_arithmetic_v<B>)
+			return (b < a) - (a < b);
+		else if constexpr(has_compare<A, B>::value)
+			return static_cast<int>(a.compare(b));
+		else if constexpr(std::is_convertible_v<const A&, std::string_view> &&
+						  std::is_convertible_v<const B&, std::string_view>)
+			return std::string_view{a}.compare(std::string_view{b});
+		else
+			return a < b ? -1 : (b < a ? 1 : 0);
+	}
+
+	/**
+	 * Auxiliary comparer, simple operator overloading could've
+	 * been used but I wanted to implement this more in the spirit
+	 * of the STL. It is transparent, so the trees can be searched
+	 * with any key type comparable with T (e.g. std::string_view
+	 * for std::string keys) without constructing a T.
+	 */
+	template<typename T>
+	struct SplayComparator
+	{
+		using is_transparent = void;
+
+		/**
+		 * Returns true if the key of a given node is less
+		 * than a given key.
+		 */
+		template<typename N, typename K = T>
+		bool operator()(const N& a, const K& key) const
+		{
+			return a.key < key;
+		}
+
+		/**
+		 * Returns a negative number if the key of a given node
+		 * is less than a given key, zero if they are equal and
+		 * a positive number otherwise.
+		 */
+		template<typename N, typename K = T>
+		int compare(const N& a, const K& key) const
+		{
+			return three_way_compare(a.key, key);
+		}
+	};
+
+	/**
+	 * Type trait that is true for comparators that provide
+	 * the three-way compare function.
+	 */
+	template<typename C, typename N, typename K, typename = void>
+	struct compares_three_way : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename C, typename N, typename K>
+	struct compares_three_way<C, N, K, std::void_t<decltype(
+		std::declval<const C&>().compare(std::declval<const N&>(), std::declval<const K&>())
+	)>> : std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Type trait that is true for comparators that allow
+	 * lookups with keys of other types.
+	 */
+	template<typename C, typename = void>
+	struct is_transparent : std::false_type
+	{ /* DUMMY BODY */ };
+
+	template<typename C>
+	struct is_transparent<C, std::void_t<typename C::is_transparent>>
+		: std::true_type
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Compares the key of a given node with a given key using
+	 * a given comparator, comparators that only provide the less
+	 * than operator need an additional equality test.
+	 * Returns a negative number if the key of the node is less
+	 * than the given key, zero if they are equal and a positive
+	 * number otherwise.
+	 */
+	template<typename C, typename N, typename K>
+	int compare(const C& comparator, const N& node, const K& key)
+	{
+		if constexpr(compares_three_way<C, N, K>::value)
+			return comparator.compare(node, key);
+		else if(comparator(node, key))
+			return -1;
+		else
+			return node.key == key ? 0 : 1;
+	}
+
+	/**
+	 * Node-like view of a key, it allows comparators, which compare
+	 * the key of a node with another key, to compare two keys.
+	 */
+	template<typename T>
+	struct KeyView
+	{
+		/**
+		 * The viewed key.
+		 */
+		const T& key;
+	};
+
+	/**
+	 * Returns true if a given key comes before another
+	 * given key in the order of a given comparator.
+	 */
+	template<typename C, typename T, typename K>
+	bool less(const C& comparator, const T& a, const K& b)
+	{
+		return comparator(KeyView<T>{a}, b);
+	}
+
+	/**
+	 * Returns a key a tree with keys of type T and a given
+	 * comparator can be searched with, keys of other types
+	 * are converted to T unless the comparator is transparent.
+	 */
+	template<typename T, typename C, typename K>
+	decltype(auto) lookup_key(const K& key)
+	{
+		if constexpr(std::is_same_v<K, T> || is_transparent<C>::value)
+			return (key);
+		else
+			return T(key);
+	}
+
+	/**
+	 * Returns a string representation of a given key.
+	 */
+	template<typename T>
+	std::string to_string(const T& key)
+	{
+		if constexpr(std::is_arithmetic_v<T>)
+			return std::to_string(key);
+		else if constexpr(std::is_convertible_v<const T&, std::string_view>)
+			return std::string{std::string_view{key}};
+		else
+		{
+			std::ostringstream stream{};
+			stream << key;
+			return stream.str();
+		}
+	}
+}
+
+/**
+ * Memory for the characters of long ArenaString keys, strings are
+ * copied into large blocks and are never freed one by one, only all
+ * at once when the arena is cleared or destroyed. Keys (and thus trees)
+ * that use an arena must not outlive it. Not thread safe.
+ */
+class StringArena
+{
+	public:
+		/**
+		 * Constructor.
+		 */
+		StringArena() = default;
+
+		/**
+		 * The arena owns the strings.
+		 */
+		StringArena(const StringArena&) = delete;
+		StringArena& operator=(const StringArena&) = delete;
+
+		/**
+		 * Copies a given string into the arena and returns
+		 * a pointer to its first character.
+		 */
+		const char* store(std::string_view string)
+		{
+			if(string.size() > left_)
+			{
+				auto size = std::max(block_size_, string.size());
+				blocks_.emplace_back(new char[size]);
+				next_ = blocks_.back().get();
+				left_ = size;
+			}
+
+			auto res = next_;
+			std::memcpy(next_, string.data(), string.size());
+			next_ += string.size();
+			left_ -= string.size();
+
+			return res;
+		}
+
+		/**
+		 * Frees all strings stored in the arena.
+		 */
+		void clear()
+		{
+			blocks_.clear();
+			next_ = nullptr;
+			left_ = std::size_t{};
+		}
+
+		/**
+		 * Returns the number of blocks the arena consists of.
+		 */
+		std::size_t block_count() const
+		{
+			return blocks_.size();
+		}
+
+	private:
+		/**
+		 * Size of a single block, longer strings get
+		 * a block of their own.
+		 */
+		static constexpr std::size_t block_size_{1 << 16};
+
+		/**
+		 * Blocks of memory holding the strings.
+		 */
+		std::vector<std::unique_ptr<char[]>> blocks_{};
+
+		/**
+		 * Position the next string is stored at.
+		 */
+		char* next_{};
+
+		/**
+		 * Number of free characters in the last block.
+		 */
+		std::size_t left_{};
+};
+
+/**
+ * String key that takes 16 bytes in the node, strings of up to
+ * inline_capacity characters are kept in the node itself, longer
+ * ones are stored in a StringArena shared by the keys and the node
+ * only keeps their first prefix_size characters and a pointer to them.
+ * Comparisons start with the prefix, so keys that differ in it are
+ * compared without touching the arena.
+ */
+class ArenaString
+{
+	public:
+		/**
+		 * Maximal length of strings kept in the node.
+		 */
+		static constexpr std::size_t inline_capacity{12};
+
+		/**
+		 * Number of characters always kept in the node.
+		 */
+		static constexpr std::size_t prefix_size{4};
+
+		/**
+		 * Constructor, creates an empty string.
+		 */
+		ArenaString() = default;
+
+		/**
+		 * Constructor.
+		 * Param: The string.
+		 * Param: Arena the string is stored in if it is too long
+		 *        to be kept inline.
+		 */
+		ArenaString(std::string_view string, StringArena& arena)
+			: length_{static_cast<std::uint32_t>(string.size())}
+		{
+			if(string.size() > std::numeric_limits<std::uint32_t>::max())
+				throw std::length_error{"String key is too long."};
+
+			if(string.size() <= inline_capacity)
+				std::memcpy(chars_, string.data(), string.size());
+			else
+			{
+				auto data = arena.store(string);
+				std::memcpy(chars_, string.data(), prefix_size);
+				std::memcpy(chars_ + prefix_size, &data, sizeof(data));
+			}
+		}
+
+		/**
+		 * Returns the number of characters.
+		 */
+		std::size_t size() const
+		{
+			return length_;
+		}
+
+		/**
+		 * Returns a pointer to the first character.
+		 */
+		const char* data() const
+		{
+			if(length_ <= inline_capacity)
+				return chars_;
+
+			const char* data{};
+			std::memcpy(&data, chars_ + prefix_size, sizeof(data));
+			return data;
+		}
+
+		/**
+		 * Returns a view of the string.
+		 */
+		std::string_view view() const
+		{
+			return std::string_view{data(), length_};
+		}
+
+		/**
+		 * Converts the string to a view.
+		 */
+		operator std::string_view() const
+		{
+			return view();
+		}
+
+		/**
+		 * Compares the string with another one, returns a negative
+		 * number if it is less than the other one, zero if they are
+		 * equal and a positive number otherwise.
+		 */
+		int compare(std::string_view other) const
+		{
+			auto prefix = std::min({std::size_t{length_}, other.size(), prefix_size});
+			if(auto res = std::memcmp(chars_, other.data(), prefix))
+				return res;
+
+			return view().substr(prefix).compare(other.substr(prefix));
+		}
+
+		/**
+		 * Compares the string with another one, see above.
+		 */
+		int compare(const ArenaString& other) const
+		{
+			auto prefix = std::min({length_, other.length_, std::uint32_t{prefix_size}});
+			if(auto res = std::memcmp(chars_, other.chars_, prefix))
+				return res;
+
+			return view().substr(prefix).compare(other.view().substr(prefix));
+		}
+
+		/**
+		 * Comparison operators, strings of different lengths
+		 * are never equal.
+		 */
+		friend bool operator==(const ArenaString& a, const ArenaString& b)
+		{
+			return a.length_ == b.length_ && a.compare(b) == 0;
+		}
+
+		friend bool operator==(const ArenaString& a, std::string_view b)
+		{
+			return a.length_ == b.size() && a.compare(b) == 0;
+		}
+
+		friend bool operator!=(const ArenaString& a, const ArenaString& b)
+		{
+			return !(a == b);
+		}
+
+		friend bool operator<(const ArenaString& a, const ArenaString& b)
+		{
+			return a.compare(b) < 0;
+		}
+
+		friend bool operator<(const ArenaString& a, std::string_view b)
+		{
+			return a.compare(b) < 0;
+		}
+
+		friend bool operator<(std::string_view a, const ArenaString& b)
+		{
+			return b.compare(a) > 0;
+		}
+
+		/**
+		 * Writes the string to a given stream.
+		 */
+		friend std::ostream& operator<<(std::ostream& out, const ArenaString& string)
+		{
+			return out << string.view();
+		}
+
+	private:
+		/**
+		 * Number of characters.
+		 */
+		std::uint32_t length_{};
+
+		/**
+		 * Either the whole string or its prefix followed
+		 * by a pointer to the string in the arena.
+		 */
+		char chars_[inline_capacity]{};
+};
+
+/**
+ * Allocator that creates every node on its own using
+ * new and delete.
+ */
+template<typename N>
+struct NewDeleteAllocator
+{
+	/**
+	 * Every node has to be returned to the allocator
+	 * on its own.
+	 */
+	static constexpr bool releases_in_bulk{false};
+
+	/**
+	 * Creates a new node.
+	 * Param: Arguments passed to the constructor of the node.
+	 */
+	template<typename... Args>
+	N* allocate(Args&&... args)
+	{
+		return new N{std::forward<Args>(args)...};
+	}
+
+	/**
+	 * Destroys a given node.
+	 */
+	void deallocate(N* node)
+	{
+		delete node;
+	}
+
+	/**
+	 * Nothing to recycle, all nodes have already been
+	 * deallocated one by one.
+	 */
+	void reset()
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Nodes are not preallocated.
+	 */
+	void reserve(std::size_t)
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Nodes do not share any memory.
+	 */
+	bool exclusive() const
+	{
+		return true;
+	}
+
+	/**
+	 * Nodes can be moved between trees freely.
+	 */
+	void adopt(const NewDeleteAllocator&)
+	{ /* DUMMY BODY */ }
+};
+
+/**
+ * Arena allocator that carves nodes out of large slabs, nodes
+ * allocated one after another thus end up next to each other
+ * in memory and the whole arena is freed at once when the last
+ * allocator using it is destroyed. Deallocated nodes are kept in
+ * a free list and reused. Trees that exchange nodes (split, join)
+ * share a single reference counted arena, so a split only copies
+ * the reference and joining trees of the same arena costs nothing.
+ * Every allocator has its own free list and its own part of a slab,
+ * so allocators sharing an arena can be used by different threads,
+ * the arena is locked only when an allocator runs out of memory.
+ */
+template<typename N>
+class SlabAllocator
+{
+	public:
+		/**
+		 * All nodes are freed when the allocator is destroyed,
+		 * so the tree does not need to return them one by one.
+		 */
+		static constexpr bool releases_in_bulk{true};
+
+		/**
+		 * Constructor, the arena is created by the first allocation.
+		 */
+		SlabAllocator() = default;
+
+		/**
+		 * Destructor, if other allocators still use the arena,
+		 * the unused memory of this one is left to them.
+		 */
+		~SlabAllocator()
+		{
+			release_();
+		}
+
+		/**
+		 * Copy constructor, the copy shares the arena (and thus keeps
+		 * the nodes allocated so far alive) but allocates new nodes
+		 * from its own part of it.
+		 */
+		SlabAllocator(const SlabAllocator& other)
+			: arena_{other.arena_}
+		{ /* DUMMY BODY */ }
+
+		SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+		/**
+		 * Move constructor, the arena and the free list are taken
+		 * over, the other allocator ends up without any memory.
+		 */
+		SlabAllocator(SlabAllocator&& other) noexcept
+			: arena_{std::move(other.arena_)},
+			  next_{std::exchange(other.next_, nullptr)},
+			  end_{std::exchange(other.end_, nullptr)},
+			  free_{std::exchange(other.free_, nullptr)}
+		{ /* DUMMY BODY */ }
+
+		/**
+		 * Move assignment, the arena of this allocator is released
+		 * (freed unless shared) and that of the other one taken over.
+		 */
+		SlabAllocator& operator=(SlabAllocator&& other) noexcept
+		{
+			if(&other != this)
+			{
+				release_();
+				arena_ = std::move(other.arena_);
+				next_ = std::exchange(other.next_, nullptr);
+				end_ = std::exchange(other.end_, nullptr);
+				free_ = std::exchange(other.free_, nullptr);
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Creates a new node in the current part of a slab, or
+		 * reuses one that has been deallocated.
+		 * Param: Arguments passed to the constructor of the node.
+		 */
+		template<typename... Args>
+		N* allocate(Args&&... args)
+		{
+			if(!free_ && next_ == end_)
+				refill_();
+
+			Slot* slot{};
+			if(free_)
+			{
+				slot = free_;
+				free_ = free_->next;
+			}
+			else
+				slot = next_++;
+
+			return new (slot->storage) N{std::forward<Args>(args)...};
+		}
+
+		/**
+		 * Destroys a given node and keeps its memory for later
+		 * allocations.
+		 */
+		void deallocate(N* node)
+		{
+			node->~N();
+
+			auto slot = reinterpret_cast<Slot*>(node);
+			slot->next = free_;
+			free_ = slot;
+		}
+
+		/**
+		 * Marks all memory of the arena as unused without freeing
+		 * it, the nodes must have been destroyed already (or be
+		 * trivially destructible) and no other allocator may use
+		 * the arena.
+		 */
+		void reset()
+		{
+			free_ = next_ = end_ = nullptr;
+			if(!arena_)
+				return;
+
+			auto lock = lock_();
+			auto& arena = *arena_;
+			arena.free = arena.free_tail = nullptr;
+			arena.spare.clear();
+			for(auto slab = arena.slabs.rbegin(); slab != arena.slabs.rend(); ++slab)
+				arena.spare.emplace_back(slab->slots.get(), slab->slots.get() + slab->size);
+		}
+
+		/**
+		 * Makes sure the slabs of the arena can hold at least
+		 * a given number of nodes in total.
+		 */
+		void reserve(std::size_t count)
+		{
+			auto lock = lock_();
+			if(count > arena_->capacity)
+				arena_->add_slab(count - arena_->capacity);
+		}
+
+		/**
+		 * Returns true if no other allocator uses the arena.
+		 */
+		bool exclusive()
+		{
+			if(!arena_)
+				return true;
+
+			auto lock = lock_(); // Follows merges, allocators release the arena under the lock.
+			return arena_.use_count() == 1;
+		}
+
+		/**
+		 * Starts sharing the arena of another allocator, this has to be
+		 * done before nodes allocated by the other allocator are moved
+		 * to a tree using this one. Allocators that already share the
+		 * arena (e.g. of trees split from one tree) need nothing else.
+		 * Two different arenas are merged into one, the slabs of the one
+		 * with fewer slabs are moved to the other one, which from then
+		 * on is used by all allocators of both.
+		 */
+		void adopt(SlabAllocator& other)
+		{
+			if(!other.arena_)
+				return;
+			if(!arena_)
+			{
+				arena_ = other.arena_;
+				return;
+			}
+
+			while(true)
+			{
+				lock_();
+				other.lock_();
+				if(arena_ == other.arena_)
+					return;
+
+				std::shared_ptr<Arena> target{};
+				{
+					std::scoped_lock lock{arena_->mutex, other.arena_->mutex};
+					if(arena_->merged_into || other.arena_->merged_into)
+						continue; // Merged by another thread in the meantime.
+
+					auto into = arena_;
+					auto from = other.arena_;
+					if(into->slabs.size() < from->slabs.size())
+						std::swap(into, from);
+					into->merge(*from);
+					from->merged_into = into;
+					target = std::move(into);
+				}
+
+				// Only now, the arenas must not be destroyed while locked.
+				arena_ = target;
+				other.arena_ = std::move(target);
+				return;
+			}
+		}
+
+	private:
+		/**
+		 * Memory for a single node, while the node is not
+		 * allocated it links the free list.
+		 */
+		union Slot
+		{
+			Slot* next;
+			alignas(N) unsigned char storage[sizeof(N)];
+		};
+
+		/**
+		 * Size (in nodes) of the first slab, subsequent slabs
+		 * double in size up to the maximal size.
+		 */
+		static constexpr std::size_t first_slab_size{64};
+		static constexpr std::size_t max_slab_size{std::size_t{1} << 16};
+
+		/**
+		 * Continuous block of node slots.
+		 */
+		struct Slab
+		{
+			std::unique_ptr<Slot[]> slots;
+			std::size_t size;
+		};
+
+		/**
+		 * Memory shared by all allocators of the trees that
+		 * exchange nodes.
+		 */
+		struct Arena
+		{
+			/**
+			 * Allocates a new slab of a given size (in nodes)
+			 * and marks it as unused.
+			 */
+			void add_slab(std::size_t size)
+			{
+				slabs.push_back(Slab{std::unique_ptr<Slot[]>{new Slot[size]}, size});
+				spare.emplace_back(slabs.back().slots.get(), slabs.back().slots.get() + size);
+				capacity += size;
+			}
+
+			/**
+			 * Takes over the slabs and the unused memory
+			 * of another arena.
+			 */
+			void merge(Arena& other)
+			{
+				std::move(other.slabs.begin(), other.slabs.end(), std::back_inserter(slabs));
+				spare.insert(spare.end(), other.spare.begin(), other.spare.end());
+				if(other.free)
+				{
+					other.free_tail->next = free;
+					if(!free)
+						free_tail = other.free_tail;
+					free = other.free;
+				}
+				capacity += other.capacity;
+
+				other.slabs.clear();
+				other.spare.clear();
+				other.free = other.free_tail = nullptr;
+				other.capacity = std::size_t{};
+			}
+
+			/**
+			 * Lock of the arena.
+			 */
+			std::mutex mutex{};
+
+			/**
+			 * Slabs the nodes are allocated from.
+			 */
+			std::vector<Slab> slabs{};
+
+			/**
+			 * Parts of the slabs no allocator uses, the last
+			 * one is handed out first.
+			 */
+			std::vector<std::pair<Slot*, Slot*>> spare{};
+
+			/**
+			 * Nodes deallocated by allocators that no longer
+			 * use the arena.
+			 */
+			Slot* free{};
+			Slot* free_tail{};
+
+			/**
+			 * Total number of nodes the slabs can hold.
+			 */
+			std::size_t capacity{};
+
+			/**
+			 * Arena this one has been merged into (if any).
+			 */
+			std::shared_ptr<Arena> merged_into{};
+		};
+
+		/**
+		 * Locks the arena (which is created if there is none yet),
+		 * if it has been merged into another one, that one is used
+		 * from now on.
+		 */
+		std::unique_lock<std::mutex> lock_()
+		{
+			if(!arena_)
+				arena_ = std::make_shared<Arena>();
+
+			while(true)
+			{
+				std::unique_lock<std::mutex> lock{arena_->mutex};
+				if(!arena_->merged_into)
+					return lock;
+
+				auto target = arena_->merged_into;
+				lock.unlock();
+				arena_ = std::move(target);
+			}
+		}
+
+		/**
+		 * Takes the nodes returned to the arena or an unused part of
+		 * a slab, a new slab is allocated if there is neither.
+		 */
+		void refill_()
+		{
+			auto lock = lock_();
+			auto& arena = *arena_;
+			if(arena.free)
+			{
+				free_ = std::exchange(arena.free, nullptr);
+				arena.free_tail = nullptr;
+				return;
+			}
+
+			if(arena.spare.empty())
+			{
+				arena.add_slab(arena.slabs.empty() ? first_slab_size
+							   : std::min(arena.slabs.back().size * 2, max_slab_size));
+			}
+			next_ = arena.spare.back().first;
+			end_ = arena.spare.back().second;
+			arena.spare.pop_back();
+		}
+
+		/**
+		 * Stops using the arena, the unused memory of this
+		 * allocator is left to the others (if any).
+		 */
+		void release_()
+		{
+			if(!arena_)
+				return;
+
+			auto lock = lock_();
+			if(arena_.use_count() > 1)
+			{
+				auto& arena = *arena_;
+				if(next_ != end_)
+					arena.spare.emplace_back(next_, end_);
+				if(free_)
+				{
+					auto tail = free_;
+					while(tail->next)
+						tail = tail->next;
+
+					tail->next = arena.free;
+					if(!arena.free)
+						arena.free_tail = tail;
+					arena.free = free_;
+				}
+			}
+			lock.unlock();
+
+			arena_.reset();
+			free_ = next_ = end_ = nullptr;
+		}
+
+		/**
+		 * Arena the nodes are allocated from.
+		 */
+		std::shared_ptr<Arena> arena_{};
+
+		/**
+		 * Next unused slot and the end of the part
+		 * of a slab this allocator uses.
+		 */
+		Slot* next_{};
+		Slot* end_{};
+
+		/**
+		 * Head of the list of deallocated slots.
+		 */
+		Slot* free_{};
+};
+
+/**
+ * Node storage that addresses nodes by pointers, the nodes are
+ * created by a given allocator. The rotator and the splay policies access
+ * the nodes only through a storage, this one is used for plain nodes.
+ */
+template<typename N, template<typename> class Allocator = NewDeleteAllocator>
+class PointerNodeStorage
+{
+	public:
+		/**
+		 * Type of the nodes.
+		 */
+		using node_type = N;
+
+		/**
+		 * Type that refers to a node.
+		 */
+		using handle = N*;
+
+		/**
+		 * Handle that refers to no node.
+		 */
+		static constexpr handle null{nullptr};
+
+		/**
+		 * True if the allocator frees all nodes at once.
+		 */
+		static constexpr bool releases_in_bulk{Allocator<N>::releases_in_bulk};
+
+		/**
+		 * Returns the node a given handle refers to.
+		 */
+		N& node(handle pointer)
+		{
+			return *pointer;
+		}
+
+		const N& node(handle pointer) const
+		{
+			return *pointer;
+		}
+
+		/**
+		 * Returns the link to the left son of a given node.
+		 */
+		handle& left(handle node)
+		{
+			return node->left;
+		}
+
+		const handle& left(handle node) const
+		{
+			return node->left;
+		}
+
+		/**
+		 * Returns the link to the right son of a given node.
+		 */
+		handle& right(handle node)
+		{
+			return node->right;
+		}
+
+		const handle& right(handle node) const
+		{
+			return node->right;
+		}
+
+		/**
+		 * Returns the link to the parent of a given node.
+		 */
+		handle& parent(handle node)
+		{
+			return node->parent;
+		}
+
+		const handle& parent(handle node) const
+		{
+			return node->parent;
+		}
+
+		/**
+		 * Creates a node from given arguments and returns its handle.
+		 */
+		template<typename... Args>
+		handle allocate(Args&&... args)
+		{
+			return allocator_.allocate(std::forward<Args>(args)...);
+		}
+
+		/**
+		 * Destroys a given node.
+		 */
+		void deallocate(handle node)
+		{
+			allocator_.deallocate(node);
+		}
+
+		/**
+		 * Marks the memory of the allocator as unused,
+		 * see SlabAllocator::reset.
+		 */
+		void reset()
+		{
+			allocator_.reset();
+		}
+
+		/**
+		 * Makes sure a given number of nodes can be
+		 * created without allocating more memory.
+		 */
+		void reserve(std::size_t count)
+		{
+			allocator_.reserve(count);
+		}
+
+		/**
+		 * Returns true if no other storage shares
+		 * the memory of the allocator.
+		 */
+		bool exclusive()
+		{
+			return allocator_.exclusive();
+		}
+
+		/**
+		 * Takes over the nodes of another storage, the nodes keep
+		 * their addresses, so only the allocators are joined (see
+		 * SlabAllocator::adopt).
+		 * Param: The other storage.
+		 * Param: Root of the subtree that is taken over.
+		 * Returns the root of the subtree in this storage.
+		 */
+		handle adopt(PointerNodeStorage& other, handle root)
+		{
+			allocator_.adopt(other.allocator_);
+			return root;
+		}
+
+	private:
+		/**
+		 * Allocator that provides memory for the nodes.
+		 */
+		Allocator<N> allocator_{};
+};
+
+/**
+ * Node storage that keeps all nodes in a single contiguous array
+ * and addresses them by 32-bit indices (see CompactNode), which halves
+ * the size of a node with a small key and keeps the nodes of a tree
+ * close to each other. Removed nodes are kept in a free list (linked
+ * through their left sons) and reused. Copies of a storage (e.g. of
+ * trees split from one tree) share the array, which is freed with the
+ * last of them, but unlike SlabAllocator the storages sharing an array
+ * cannot be used concurrently.
+ * Note: Growing the array invalidates references to the nodes
+ *       and links, but not the handles.
+ */
+template<typename N>
+class IndexedNodeStorage
+{
+	public:
+		/**
+		 * Type of the nodes.
+		 */
+		using node_type = N;
+
+		/**
+		 * Type that refers to a node.
+		 */
+		using handle = std::uint32_t;
+
+		/**
+		 * Handle that refers to no node.
+		 */
+		static constexpr handle null{N::none};
+
+		/**
+		 * The nodes are destroyed with the array.
+		 */
+		static constexpr bool releases_in_bulk{true};
+
+		/**
+		 * Constructor, the array is created by the first allocation.
+		 */
+		IndexedNodeStorage() = default;
+
+		/**
+		 * Copy constructor, the copy shares the array.
+		 */
+		IndexedNodeStorage(const IndexedNodeStorage& other)
+			: arena_{other.arena_}
+		{ /* DUMMY BODY */ }
+
+		IndexedNodeStorage& operator=(const IndexedNodeStorage&) = delete;
+		IndexedNodeStorage(IndexedNodeStorage&&) noexcept = default;
+		IndexedNodeStorage& operator=(IndexedNodeStorage&&) noexcept = default;
+
+		/**
+		 * Returns the node a given handle refers to.
+		 */
+		N& node(handle index)
+		{
+			return arena_->nodes[index];
+		}
+
+		const N& node(handle index) const
+		{
+			return arena_->nodes[index];
+		}
+
+		/**
+		 * Returns the link to the left son of a given node.
+		 */
+		handle& left(handle node)
+		{
+			return arena_->nodes[node].left;
+		}
+
+		const handle& left(handle node) const
+		{
+			return arena_->nodes[node].left;
+		}
+
+		/**
+		 * Returns the link to the right son of a given node.
+		 */
+		handle& right(handle node)
+		{
+			return arena_->nodes[node].right;
+		}
+
+		const handle& right(handle node) const
+		{
+			return arena_->nodes[node].right;
+		}
+
+		/**
+		 * Returns the link to the parent of a given node.
+		 */
+		handle& parent(handle node)
+		{
+			return arena_->nodes[node].parent;
+		}
+
+		const handle& parent(handle node) const
+		{
+			return arena_->nodes[node].parent;
+		}
+
+		/**
+		 * Creates a node from given arguments and returns its handle.
+		 */
+		template<typename... Args>
+		handle allocate(Args&&... args)
+		{
+			auto& arena = use_arena_();
+			if(arena.free != null)
+			{
+				auto node = arena.free;
+				arena.free = arena.nodes[node].left;
+				arena.nodes[node] = N(std::forward<Args>(args)...);
+				return node;
+			}
+
+			if(arena.nodes.size() >= null)
+				throw std::length_error{"Too many nodes for 32-bit indices."};
+
+			arena.nodes.emplace_back(std::forward<Args>(args)...);
+			return static_cast<handle>(arena.nodes.size() - 1);
+		}
+
+		/**
+		 * Returns a node to the storage for reuse.
+		 */
+		void deallocate(handle node)
+		{
+			arena_->nodes[node].left = arena_->free;
+			arena_->free = node;
+		}
+
+		/**
+		 * Removes all nodes, the memory is kept for reuse.
+		 * No other storage may share the array.
+		 */
+		void reset()
+		{
+			if(!arena_)
+				return;
+
+			arena_->nodes.clear();
+			arena_->free = null;
+		}
+
+		/**
+		 * Makes sure a given number of nodes can be stored
+		 * without growing the array.
+		 */
+		void reserve(std::size_t count)
+		{
+			use_arena_().nodes.reserve(count);
+		}
+
+		/**
+		 * Returns true if no other storage shares the array.
+		 */
+		bool exclusive() const
+		{
+			return !arena_ || arena_.use_count() == 1;
+		}
+
+		/**
+		 * Takes over the nodes of another storage, the nodes are
+		 * moved to the array of this storage (in O(m) for m nodes)
+		 * unless the storages share the array.
+		 * Param: The other storage.
+		 * Param: Root of the subtree that is taken over.
+		 * Returns the root of the subtree in this storage.
+		 */
+		handle adopt(IndexedNodeStorage& other, handle root)
+		{
+			if(root == null || other.arena_ == arena_)
+				return root;
+
+			// Nodes of the other storage with the parents of their copies.
+			handle res{null};
+			std::vector<std::tuple<handle, handle, bool>> stack{{root, null, true}};
+			while(!stack.empty())
+			{
+				auto [node, parent, is_left] = stack.back();
+				stack.pop_back();
+
+				auto left = other.left(node);
+				auto right = other.right(node);
+				auto copy = allocate(std::move(other.node(node)));
+				other.deallocate(node);
+
+				this->left(copy) = this->right(copy) = null;
+				if constexpr(utils::has_parent<N>::value)
+					this->parent(copy) = parent;
+				if(parent == null)
+					res = copy;
+				else
+					(is_left ? this->left(parent) : this->right(parent)) = copy;
+
+				if(left != null)
+					stack.emplace_back(left, copy, true);
+				if(right != null)
+					stack.emplace_back(right, copy, false);
+			}
+
+			return res;
+		}
+
+	private:
+		/**
+		 * The nodes and the free list shared by the copies.
+		 */
+		struct Arena
+		{
+			/**
+			 * The nodes.
+			 */
+			std::vector<N> nodes{};
+
+			/**
+			 * First node of the free list.
+			 */
+			handle free{null};
+		};
+
+		/**
+		 * Returns the array, which is created if there is none yet.
+		 */
+		Arena& use_arena_()
+		{
+			if(!arena_)
+				arena_ = std::make_shared<Arena>();
+
+			return *arena_;
+		}
+
+		/**
+		 * Array of the nodes.
+		 */
+		std::shared_ptr<Arena> arena_{};
+};
+
+/**
+ * Auxiliary namespace containing functions used
+ * for better code readability.
+ */
+namespace utils
+{
+	/**
+	 * Type trait that selects the storage of nodes of a given type
+	 * for a given allocator template, allocators are wrapped in
+	 * a PointerNodeStorage, node storages (e.g. IndexedNodeStorage)
+	 * are used as they are.
+	 */
+	template<template<typename> class Allocator, typename N, typename = void>
+	struct node_storage
+	{
+		using type = PointerNodeStorage<N, Allocator>;
+	};
+
+	template<template<typename> class Allocator, typename N>
+	struct node_storage<Allocator, N, std::void_t<typename Allocator<N>::handle>>
+	{
+		using type = Allocator<N>;
+	};
+}
+
+/**
+ * Statistics policy that collects nothing, all hooks are
+ * empty, so a tree using it pays nothing for them.
+ */
+struct NoSplayStatistics
+{
+	/**
+	 * Called for every zig step (a single rotation
+	 * of the splayed node with its parent).
+	 */
+	void zig()
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Called for every zig-zig step (the parent and the
+	 * node rotated in the same direction).
+	 */
+	void zig_zig()
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Called for every zig-zag step (the node rotated
+	 * twice in opposite directions).
+	 */
+	void zig_zag()
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Called for every single rotation.
+	 */
+	void rotation()
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Called for every search with its depth.
+	 */
+	void search(std::size_t)
+	{ /* DUMMY BODY */ }
+
+	/**
+	 * Called when the statistics of the tree are reset.
+	 */
+	void reset()
+	{ /* DUMMY BODY */ }
+};
+
+/**
+ * Statistics policy that counts the splay steps and rotations
+ * and keeps a histogram of search depths.
+ */
+struct SplayStatistics
+{
+	/**
+	 * Number of buckets of the depth histogram, bucket 0 counts
+	 * searches of depth 0 and bucket i > 0 those of depth
+	 * in [2^(i - 1), 2^i).
+	 */
+	static constexpr std::size_t histogram_size{64};
+
+	/**
+	 * Counts a zig step.
+	 */
+	void zig()
+	{
+		++zigs;
+	}
+
+	/**
+	 * Counts a zig-zig step.
+	 */
+	void zig_zig()
+	{
+		++zig_zigs;
+	}
+
+	/**
+	 * Counts a zig-zag step.
+	 */
+	void zig_zag()
+	{
+		++zig_zags;
+	}
+
+	/**
+	 * Counts a single rotation, the rotations of
+	 * double steps are counted one by one.
+	 */
+	void rotation()
+	{
+		++rotations;
+	}
+
+	/**
+	 * Records a search of a given depth.
+	 */
+	void search(std::size_t depth)
+	{
+		std::size_t bucket{};
+		while(depth >> bucket)
+			++bucket;
+
+		++searches;
+		++depth_histogram[bucket];
+		max_depth = std::max(max_depth, depth);
+	}
+
+	/**
+	 * Sets all counters to zero.
+	 */
+	void reset()
+	{
+		*this = SplayStatistics{};
+	}
+
+	/**
+	 * Prints the statistics as a JSON object (without the braces,
+	 * so the caller can add more fields).
+	 */
+	void print(std::ostream& output) const
+	{
+		output << "\"zigs\":" << zigs
+			   << ",\"zig_zigs\":" << zig_zigs
+			   << ",\"zig_zags\":" << zig_zags
+			   << ",\"rotations\":" << rotations
+			   << ",\"searches\":" << searches
+			   << ",\"max_depth\":" << max_depth
+			   << ",\"depth_histogram\":[";
+
+		auto last = histogram_size;
+		while(last > 1 && depth_histogram[last - 1] == 0)
+			--last;
+		for(std::size_t i = 0; i < last; ++i)
+			output << (i ? "," : "") << depth_histogram[i];
+		output << "]";
+	}
+
+	/**
+	 * Number of zig steps.
+	 */
+	std::size_t zigs{};
+
+	/**
+	 * Number of zig-zig steps.
+	 */
+	std::size_t zig_zigs{};
+
+	/**
+	 * Number of zig-zag steps.
+	 */
+	std::size_t zig_zags{};
+
+	/**
+	 * Number of single rotations.
+	 */
+	std::size_t rotations{};
+
+	/**
+	 * Number of searches.
+	 */
+	std::size_t searches{};
+
+	/**
+	 * Depth of the deepest search.
+	 */
+	std::size_t max_depth{};
+
+	/**
+	 * Number of searches per depth bucket (see histogram_size).
+	 */
+	std::size_t depth_histogram[histogram_size]{};
+};
+
+/**
+ * Result of a single lookup of a batched find.
+ */
+struct FindResult
+{
+	/**
+	 * True if the key was found.
+	 */
+	bool found;
+
+	/**
+	 * Length of the traversal, see SplayTree::length_of_last_find.
+	 */
+	std::size_t length;
+};
+
+/**
+ * Class that represents a splay tree that contains keys of
+ * a given type and uses a given splay policy. The nodes are
+ * created from a given node template, trees with SizedNodes
+ * support order statistics (see OrderStatisticSplayTree).
+ * The nodes are created by a given allocator, or kept in a given
+ * node storage (see IndexedNodeStorage and CompactSplayTree).
+ */
+template<
+	typename T, typename SplayPolicy,
+	typename Comparator = utils::SplayComparator<T>,
+	template<typename> class Allocator = SlabAllocator,
+	typename Statistics = NoSplayStatistics,
+	template<typename, bool> class NodeTemplate = Node
+>
+class SplayTree
+{
+	friend bool test_3();
+	public:
+		/**
+		 * Type of the nodes this tree consists of, top-down
+		 * policies do not need the parent pointer.
+		 */
+		using node_type = NodeTemplate<T, !SplayPolicy::top_down>;
+
+		/**
+		 * Type of the storage of the nodes (see utils::node_storage).
+		 */
+		using storage_type = typename utils::node_storage<Allocator, node_type>::type;
+
+		/**
+		 * Type that refers to a node.
+		 */
+		using handle = typename storage_type::handle;
+
+		/**
+		 * Bidirectional iterator over the keys in increasing order.
+		 * It walks the tree using the parent pointers, so it needs
+		 * no extra memory, and it does not splay. Rotations keep the
+		 * order of the nodes, so it stays valid when the tree is
+		 * splayed, only erasing its key or clearing the tree invalidate
+		 * it. Trees of top-down policies have no parent pointers and
+		 * thus no iterators, use for_each_in_range with them.
+		 */
+		class const_iterator
+		{
+			public:
+				using iterator_category = std::bidirectional_iterator_tag;
+				using value_type = T;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const T*;
+				using reference = const T&;
+
+				/**
+				 * Constructor.
+				 */
+				const_iterator() = default;
+
+				/**
+				 * Returns the key the iterator points to.
+				 */
+				reference operator*() const
+				{
+					return tree_->storage_.node(node_).key;
+				}
+
+				/**
+				 * Returns a pointer to the key the iterator points to.
+				 */
+				pointer operator->() const
+				{
+					return &tree_->storage_.node(node_).key;
+				}
+
+				/**
+				 * Moves to the next greater key.
+				 */
+				const_iterator& operator++()
+				{
+					node_ = tree_->successor_(node_);
+					return *this;
+				}
+
+				const_iterator operator++(int)
+				{
+					auto res = *this;
+					++*this;
+					return res;
+				}
+
+				/**
+				 * Moves to the next smaller key, the end moves
+				 * to the greatest key.
+				 */
+				const_iterator& operator--()
+				{
+					if(node_ != storage_type::null)
+						node_ = tree_->predecessor_(node_);
+					else
+						node_ = tree_->rightmost_(tree_->root_);
+					return *this;
+				}
+
+				const_iterator operator--(int)
+				{
+					auto res = *this;
+					--*this;
+					return res;
+				}
+
+				friend bool operator==(const const_iterator& a, const const_iterator& b)
+				{
+					return a.node_ == b.node_;
+				}
+
+				friend bool operator!=(const const_iterator& a, const const_iterator& b)
+				{
+					return a.node_ != b.node_;
+				}
+
+			private:
+				friend class SplayTree;
+
+				/**
+				 * Constructor.
+				 * Param: Node the iterator points to (null for the end).
+				 * Param: Tree the node belongs to.
+				 */
+				const_iterator(handle node, const SplayTree* tree)
+					: node_{node}, tree_{tree}
+				{ /* DUMMY BODY */ }
+
+				/**
+				 * Node the iterator points to.
+				 */
+				handle node_{storage_type::null};
+
+				/**
+				 * Tree the node belongs to.
+				 */
+				const SplayTree* tree_{};
+		};
+
+		/**
+		 * Keys cannot be changed in place.
+		 */
+		using iterator = const_iterator;
+
+		/**
+		 * Constructor.
+		 */
+		SplayTree() = default;
+
+		/**
+		 * Constructor.
+		 * Param: Comparator that orders the keys.
+		 */
+		explicit SplayTree(Comparator comparator)
+			: comparator_{std::move(comparator)}
+		{ /* DUMMY BODY */ }
+
+		/**
+		 * Constructor.
+		 * Param: Iterator to the first of the keys, which have to
+		 *        be sorted in strictly increasing order of the comparator.
+		 * Param: Iterator past the last of the keys.
+		 */
+		template<typename Iterator>
+		SplayTree(Iterator first, Iterator last)
+		{
+			assign_sorted(first, last);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~SplayTree()
+		{
+			destroy_();
+		}
+
+		/**
+		 * The tree owns its nodes, so it cannot be copied
+		 * implicitly (see clone).
+		 */
+		SplayTree(const SplayTree&) = delete;
+		SplayTree& operator=(const SplayTree&) = delete;
+
+		/**
+		 * Move constructor, takes over the nodes and the memory
+		 * of the other tree in O(1), which ends up empty.
+		 */
+		SplayTree(SplayTree&& other) noexcept
+			: root_{std::exchange(other.root_, storage_type::null)},
+			  comparator_{std::move(other.comparator_)},
+			  storage_{std::move(other.storage_)},
+			  find_length_{other.find_length_},
+			  statistics_{std::move(other.statistics_)},
+			  size_{std::exchange(other.size_, std::size_t{})},
+			  policy_state_{std::move(other.policy_state_)}
+		{ /* DUMMY BODY */ }
+
+		/**
+		 * Move assignment, the keys of this tree are destroyed
+		 * and the nodes of the other tree taken over in O(1).
+		 */
+		SplayTree& operator=(SplayTree&& other) noexcept
+		{
+			if(&other != this)
+			{
+				destroy_();
+				root_ = std::exchange(other.root_, storage_type::null);
+				comparator_ = std::move(other.comparator_);
+				storage_ = std::move(other.storage_);
+				find_length_ = other.find_length_;
+				statistics_ = std::move(other.statistics_);
+				size_ = std::exchange(other.size_, std::size_t{});
+				policy_state_ = std::move(other.policy_state_);
+			}
+
+			return *this;
+		}
+
+		/**
+		 * Returns a deep copy of the tree with the same shape and
+		 * the same state of the splay policy (e.g. the random state
+		 * of ProbabilisticSplayPolicy), so that it splays the same way.
+		 * The statistics of the copy start from zero. The nodes are
+		 * copied iteratively, as splay trees can be very deep.
+		 */
+		SplayTree clone() const
+		{
+			SplayTree res{};
+			res.comparator_ = comparator_;
+			res.policy_state_ = policy_state_;
+			res.size_ = size_;
+			if(root_ == storage_type::null)
+				return res;
+
+			res.reserve(size());
+			res.root_ = res.storage_.allocate(storage_.node(root_));
+
+			// Copies still link to the sons of the original nodes.
+			std::vector<std::pair<handle, handle>> stack{{root_, res.root_}};
+			while(!stack.empty())
+			{
+				auto [node, copy] = stack.back();
+				stack.pop_back();
+				for(bool left : {true, false})
+				{
+					auto son = left ? storage_.left(node) : storage_.right(node);
+					if(son == storage_type::null)
+						continue;
+
+					auto son_copy = res.storage_.allocate(storage_.node(son));
+					(left ? res.storage_.left(copy) : res.storage_.right(copy)) = son_copy;
+					utils::set_parent(res.storage_, son_copy, copy);
+					stack.emplace_back(son, son_copy);
+				}
+			}
+
+			return res;
+		}
+
+		/**
+		 * Removes all keys from the tree, the memory used
+		 * by the nodes is kept by the allocator for reuse
+		 * (if other trees share the arena, the nodes are
+		 * put to the free list of this tree instead).
+		 */
+		void clear()
+		{
+			destroy_();
+			if(storage_.exclusive())
+				storage_.reset();
+			root_ = storage_type::null;
+			size_ = std::size_t{};
+		}
+
+		/**
+		 * Returns the number of keys in the tree, after a split it
+		 * has to be counted (once) by walking the tree.
+		 */
+		std::size_t size() const
+		{
+			if constexpr(utils::has_size<node_type>::value)
+				return utils::subtree_size(storage_, root_);
+			else
+			{
+				if(size_ == unknown_size_)
+					size_ = count_(root_);
+
+				return size_;
+			}
+		}
+
+		/**
+		 * Makes sure the tree can hold a given number of keys
+		 * without allocating more memory.
+		 */
+		void reserve(std::size_t count)
+		{
+			storage_.reserve(count);
+		}
+
+		/**
+		 * Inserts the given key into the splay tree
+		 * if that key is not yet present in the tree.
+		 */
+		void insert(const T& key)
+		{
+			insert_(key, key);
+		}
+
+		/**
+		 * Same as above, the key is moved into the node.
+		 */
+		void insert(T&& key)
+		{
+			insert_(key, std::move(key));
+		}
+
+		/**
+		 * Creates a key in place from given arguments and inserts
+		 * it if that key is not yet present in the tree. The node is
+		 * created before the lookup, so it is returned to the
+		 * allocator if the key is present.
+		 * Param: Arguments passed to the constructor of the key.
+		 */
+		template<typename... Args>
+		void emplace(Args&&... args)
+		{
+			auto node = storage_.allocate(std::in_place, std::forward<Args>(args)...);
+			if(root_ == storage_type::null)
+			{
+				root_ = node;
+				size_ = 1;
+				return;
+			}
+
+			const auto& key = storage_.node(node).key;
+			splay_closest_(key);
+
+			auto order = utils::compare(comparator_, storage_.node(root_), key);
+			if(order == 0)
+				storage_.deallocate(node); // Already present.
+			else
+				attach_(node, order);
+		}
+
+		/**
+		 * Removes the given key from the splay tree, the key is
+		 * splayed to the root and its two subtrees are joined.
+		 * Returns true if the key was present.
+		 */
+		template<typename K = T>
+		bool erase(const K& key)
+		{
+			if(root_ == storage_type::null)
+				return false;
+
+			auto&& lookup = utils::lookup_key<T, Comparator>(key);
+			splay_closest_(lookup);
+			if(utils::compare(comparator_, storage_.node(root_), lookup) != 0)
+				return false;
+
+			auto left = storage_.left(root_);
+			auto right = storage_.right(root_);
+			storage_.deallocate(root_);
+			if(size_ != unknown_size_)
+				--size_;
+
+			root_ = join_(left, right);
+			return true;
+		}
+
+		/**
+		 * Returns an iterator past the longest prefix of a given range
+		 * whose keys are sorted in strictly increasing order of the
+		 * comparator, i.e. the prefix assign_sorted can build a tree from.
+		 * Param: Iterator to the first of the keys.
+		 * Param: Iterator past the last of the keys.
+		 */
+		template<typename Iterator>
+		Iterator is_sorted_until(Iterator first, Iterator last) const
+		{
+			auto unsorted = std::adjacent_find(first, last, [this](const T& a, const T& b){
+				return !utils::less(comparator_, a, b);
+			});
+
+			return unsorted == last ? last : std::next(unsorted);
+		}
+
+		/**
+		 * Replaces the contents of the tree with keys from a given
+		 * range, the keys have to be sorted in strictly increasing
+		 * order of the comparator (see is_sorted_until). A perfectly
+		 * balanced tree is built in linear time without any rotations.
+		 * Param: Iterator to the first of the keys.
+		 * Param: Iterator past the last of the keys.
+		 */
+		template<typename Iterator>
+		void assign_sorted(Iterator first, Iterator last)
+		{
+			clear();
+
+			auto count = static_cast<std::size_t>(std::distance(first, last));
+			reserve(count);
+			root_ = build_sorted_(first, count);
+			utils::set_parent(storage_, root_, storage_type::null);
+			size_ = count;
+		}
+
+		/**
+		 * Moves all keys greater than or equal to a given key
+		 * to a new tree which is returned, this tree keeps the
+		 * smaller keys. No nodes are copied, the two trees share
+		 * the memory of the allocator.
+		 */
+		SplayTree split(const T& key)
+		{
+			auto right = split_(key);
+			size_ = root_ != storage_type::null ? unknown_size_ : std::size_t{};
+			return SplayTree{right, comparator_, storage_};
+		}
+
+		/**
+		 * Moves all keys of a given tree, which all have to be
+		 * greater than the keys of this tree, to this tree.
+		 * Throws std::invalid_argument if they are not, neither
+		 * tree is changed then.
+		 */
+		void join(SplayTree& right)
+		{
+			if(!empty() && !right.empty() && !utils::less(comparator_, *max(), *right.min()))
+				throw std::invalid_argument{"Keys of the joined tree are not all greater."};
+
+			auto right_root = storage_.adopt(right.storage_, right.root_);
+			root_ = join_(root_, right_root);
+			right.root_ = storage_type::null;
+
+			if(size_ != unknown_size_ && right.size_ != unknown_size_)
+				size_ += right.size_;
+			else
+				size_ = unknown_size_;
+			right.size_ = std::size_t{};
+		}
+
+		/**
+		 * Moves all keys of a given tree to this tree, keys present
+		 * in both trees are kept only once. Every run of keys that does
+		 * not interleave with the keys of the other tree is moved by
+		 * a single split and join.
+		 */
+		void merge(SplayTree& other)
+		{
+			auto rest = storage_.adopt(other.storage_, other.root_);
+			other.root_ = storage_type::null;
+
+			if(size_ != unknown_size_ && other.size_ != unknown_size_)
+				size_ += other.size_;
+			else
+				size_ = unknown_size_;
+			other.size_ = std::size_t{};
+
+			// All keys in merged are smaller than those in root_ and rest.
+			handle merged{storage_type::null};
+			while(root_ != storage_type::null && rest != storage_type::null)
+			{
+				splay_min_(root_);
+				splay_min_(rest);
+
+				auto order = utils::compare(comparator_, storage_.node(rest), storage_.node(root_).key);
+				if(order == 0)
+				{ // Drop the duplicate.
+					auto duplicate = rest;
+					rest = storage_.right(rest);
+					utils::set_parent(storage_, rest, storage_type::null);
+					storage_.deallocate(duplicate);
+					if(size_ != unknown_size_)
+						--size_;
+					continue;
+				}
+				else if(order < 0)
+					std::swap(root_, rest);
+
+				auto tail = split_(storage_.node(rest).key);
+				merged = join_(merged, root_);
+				root_ = tail;
+			}
+
+			root_ = join_(join_(merged, root_), rest);
+		}
+
+		/**
+		 * Returns true if this tree contains
+		 * this key already.
+		 */
+		template<typename K = T>
+		bool contains(const K& key)
+		{
+			return find_(key) != storage_type::null;
+		}
+
+		/**
+		 * Returns true if the tree contains no keys.
+		 */
+		bool empty() const
+		{
+			return root_ == storage_type::null;
+		}
+
+		/**
+		 * Returns a pointer to the smallest key or nullptr if the
+		 * tree is empty, does not splay (works with all policies).
+		 */
+		const T* min() const
+		{
+			return root_ != storage_type::null ? &storage_.node(leftmost_(root_)).key : nullptr;
+		}
+
+		/**
+		 * Returns a pointer to the greatest key or nullptr if the
+		 * tree is empty, does not splay (works with all policies).
+		 */
+		const T* max() const
+		{
+			return root_ != storage_type::null ? &storage_.node(rightmost_(root_)).key : nullptr;
+		}
+
+		/**
+		 * Returns the key of a node that has the given key.
+		 *
+		 * ...
+		 *
+		 * I know, I know, this was just used for the test,
+		 * normally it'd return the value.
+		 */
+		template<typename K = T>
+		T find(const K& key)
+		{
+			static T NOT_FOUND{};
+			auto node = find_(key);
+
+			if(node != storage_type::null)
+				return storage_.node(node).key;
+			else
+				return NOT_FOUND;
+		}
+
+		/**
+		 * Returns an iterator to the smallest key, does not splay.
+		 */
+		const_iterator begin() const
+		{
+			static_assert(utils::has_parent<node_type>::value, "Iterators need parent pointers.");
+			return const_iterator{root_ != storage_type::null ? leftmost_(root_) : storage_type::null, this};
+		}
+
+		/**
+		 * Returns an iterator past the greatest key.
+		 */
+		const_iterator end() const
+		{
+			static_assert(utils::has_parent<node_type>::value, "Iterators need parent pointers.");
+			return const_iterator{storage_type::null, this};
+		}
+
+		/**
+		 * Returns an iterator to the smallest key not less than
+		 * a given key, the lookup splays like find.
+		 */
+		template<typename K = T>
+		const_iterator lower_bound(const K& key)
+		{
+			static_assert(utils::has_parent<node_type>::value, "Iterators need parent pointers.");
+			auto&& lookup = utils::lookup_key<T, Comparator>(key);
+			auto node = access_(lookup);
+			if(node != storage_type::null && utils::compare(comparator_, storage_.node(node), lookup) < 0)
+				node = successor_(node);
+
+			return const_iterator{node, this};
+		}
+
+		/**
+		 * Returns an iterator to the smallest key greater than
+		 * a given key, the lookup splays like find.
+		 */
+		template<typename K = T>
+		const_iterator upper_bound(const K& key)
+		{
+			static_assert(utils::has_parent<node_type>::value, "Iterators need parent pointers.");
+			auto&& lookup = utils::lookup_key<T, Comparator>(key);
+			auto node = access_(lookup);
+			if(node != storage_type::null && utils::compare(comparator_, storage_.node(node), lookup) <= 0)
+				node = successor_(node);
+
+			return const_iterator{node, this};
+		}
+
+		/**
+		 * Calls a given function with every key in the range
+		 * [low, high] in increasing order. Only the lower boundary
+		 * is looked up (and splayed), the keys in the range are
+		 * visited without restructuring the tree, so a scan does not
+		 * destroy the shape the working set has built up. Trees without
+		 * parent pointers keep a stack of the nodes left to visit. The
+		 * function must not change the tree.
+		 * Param: The smallest key of the range.
+		 * Param: The greatest key of the range.
+		 * Param: Function called with the keys.
+		 */
+		template<typename K, typename Function>
+		void for_each_in_range(const K& low, const K& high, Function&& function)
+		{
+			auto&& lookup_low = utils::lookup_key<T, Comparator>(low);
+			auto&& lookup_high = utils::lookup_key<T, Comparator>(high);
+			auto node = access_(lookup_low);
+			if(node == storage_type::null)
+				return;
+
+			if constexpr(utils::has_parent<node_type>::value)
+			{
+				if(utils::compare(comparator_, storage_.node(node), lookup_low) < 0)
+					node = successor_(node);
+
+				for(; node != storage_type::null && utils::compare(comparator_, storage_.node(node), lookup_high) <= 0;
+					node = successor_(node))
+				{
+					function(static_cast<const T&>(storage_.node(node).key));
+				}
+			}
+			else
+			{ // The node is the root, so the rest of the range is in its right subtree.
+				if(utils::compare(comparator_, storage_.node(node), lookup_low) >= 0)
+				{
+					if(utils::compare(comparator_, storage_.node(node), lookup_high) > 0)
+						return;
+					function(static_cast<const T&>(storage_.node(node).key));
+				}
+
+				std::vector<handle> stack{};
+				node = storage_.right(node);
+				while(node != storage_type::null || !stack.empty())
+				{
+					for(; node != storage_type::null; node = storage_.left(node))
+						stack.push_back(node);
+
+					node = stack.back();
+					stack.pop_back();
+					if(utils::compare(comparator_, storage_.node(node), lookup_high) > 0)
+						return;
+					function(static_cast<const T&>(storage_.node(node).key));
+					node = storage_.right(node);
+				}
+			}
+		}
+
+		/**
+		 * Returns the number of keys less than a given key, i.e. the
+		 * position of the key in the sorted order if it is present.
+		 * The key is looked up like in find. Needs SizedNodes.
+		 */
+		template<typename K = T>
+		std::size_t rank(const K& key)
+		{
+			return rank_(utils::lookup_key<T, Comparator>(key), false);
+		}
+
+		/**
+		 * Returns the key at a given position in the sorted order
+		 * (starting from zero), its node is splayed. Needs SizedNodes.
+		 * Throws std::out_of_range if the tree has less keys.
+		 */
+		const T& select(std::size_t index)
+		{
+			static_assert(utils::has_size<node_type>::value, "Order statistics need SizedNodes.");
+			if(index >= size())
+				throw std::out_of_range{"Index of the selected key is out of range."};
+
+			find_length_ = std::size_t{};
+			auto node = root_;
+			while(true)
+			{
+				auto left_size = utils::subtree_size(storage_, storage_.left(node));
+				if(index == left_size)
+					break;
+				else if(index < left_size)
+					node = storage_.left(node);
+				else
+				{
+					index -= left_size + 1;
+					node = storage_.right(node);
+				}
+				++find_length_;
+			}
+
+			if constexpr(utils::splays_partially<SplayPolicy>::value)
+				SplayPolicy::access(storage_, node, root_, find_length_, size(), policy_state_, statistics_);
+			else if constexpr(SplayPolicy::top_down)
+				SplayPolicy::splay(storage_, root_, storage_.node(node).key, comparator_, statistics_);
+			else
+				SplayPolicy::splay(storage_, node, root_, statistics_);
+			statistics_.search(find_length_);
+
+			return storage_.node(node).key;
+		}
+
+		/**
+		 * Returns the number of keys in the range [low, high], both
+		 * boundaries are looked up like in find. Needs SizedNodes.
+		 */
+		template<typename K = T>
+		std::size_t count_in_range(const K& low, const K& high)
+		{
+			auto&& lookup_low = utils::lookup_key<T, Comparator>(low);
+			auto&& lookup_high = utils::lookup_key<T, Comparator>(high);
+			auto below = rank_(lookup_low, false);
+			auto up_to_high = rank_(lookup_high, true);
+
+			return up_to_high > below ? up_to_high - below : std::size_t{};
+		}
+
+		/**
+		 * Returns the aggregate (see AggregateNode) of the keys in the
+		 * range [low, high] in increasing order. The node closest to the
+		 * lower boundary is splayed to the root and the node closest to the
+		 * upper boundary to the root of its right subtree, the keys in the
+		 * range are then the root (if it is not below the range), the left
+		 * subtree of its right son and that son (if it is not above the
+		 * range). So the query takes two splays and three combinations.
+		 * Needs AggregateNodes.
+		 */
+		template<typename K = T>
+		auto aggregate(const K& low, const K& high)
+		{
+			static_assert(utils::has_aggregate<node_type>::value, "Aggregates need AggregateNodes.");
+			using aggregate_type = typename node_type::aggregate_type;
+
+			auto res = aggregate_type::identity();
+			if(root_ == storage_type::null)
+				return res;
+
+			auto&& lookup_low = utils::lookup_key<T, Comparator>(low);
+			auto&& lookup_high = utils::lookup_key<T, Comparator>(high);
+			splay_closest_(lookup_low);
+			if(utils::compare(comparator_, storage_.node(root_), lookup_high) > 0)
+				return res; // The rest of the tree is above the range.
+			if(utils::compare(comparator_, storage_.node(root_), lookup_low) >= 0)
+				res = aggregate_type::of(storage_.node(root_).key);
+			if(storage_.right(root_) == storage_type::null)
+				return res;
+
+			if constexpr(SplayPolicy::top_down)
+				SplayPolicy::splay(storage_, storage_.right(root_), lookup_high, comparator_, statistics_);
+			else
+			{ // Splay within the right subtree only.
+				auto subtree = storage_.right(root_);
+				storage_.parent(subtree) = storage_type::null;
+				auto node = find_node_with_closest_key_(subtree, lookup_high);
+				SplayPolicy::splay(storage_, node, storage_.right(root_), statistics_);
+				storage_.parent(storage_.right(root_)) = root_;
+			}
+			utils::update(storage_, root_);
+
+			auto right = storage_.right(root_);
+			if(storage_.left(right) != storage_type::null)
+				res = aggregate_type::combine(res, storage_.node(storage_.left(right)).aggregate);
+			if(utils::compare(comparator_, storage_.node(right), lookup_high) <= 0)
+				res = aggregate_type::combine(res, aggregate_type::of(storage_.node(right).key));
+
+			return res;
+		}
+
+		/**
+		 * Looks up a batch of keys, the lookups are performed in
+		 * the order of the comparator, so that every search starts
+		 * from the previously accessed node (which is at the root)
+		 * and profits from the sequential access property of splay
+		 * trees. The results are stored in the original order.
+		 * Param: Keys to look up.
+		 * Param: Number of the keys.
+		 * Param: Array of at least count results.
+		 */
+		void find_many(const T* keys, std::size_t count, FindResult* results)
+		{
+			order_.resize(count);
+			for(std::size_t i = 0; i < count; ++i)
+				order_[i] = i;
+
+			auto less = [this](const T& a, const T& b){ return utils::less(comparator_, a, b); };
+			if(!std::is_sorted(keys, keys + count, less))
+			{
+				std::sort(
+					order_.begin(), order_.end(),
+					[keys, &less](std::size_t a, std::size_t b){ return less(keys[a], keys[b]); }
+				);
+			}
+
+			for(auto i : order_)
+			{
+				auto node = access_(keys[i]);
+				results[i].found = node != storage_type::null
+								   && utils::compare(comparator_, storage_.node(node), keys[i]) == 0;
+				results[i].length = find_length_;
+			}
+		}
+
+		/**
+		 * Returns true if the tree is a valid binary
+		 * search tree.
+		 */
+		bool validate() const
+		{
+			return validate_(root_);
+		}
+
+		/**
+		 * Prints an auxiliary string representation of
+		 * this tree.
+		 */
+		void print() const
+		{
+			DEBUG(print_(root_));
+		}
+
+		/**
+		 * Returns the length of the last find traversal.
+		 */
+		std::size_t length_of_last_find() const
+		{
+			return find_length_;
+		}
+
+		/**
+		 * Returns the statistics collected since the last reset.
+		 */
+		const Statistics& statistics() const
+		{
+			return statistics_;
+		}
+
+		/**
+		 * Sets all statistics to zero.
+		 */
+		void reset_statistics()
+		{
+			statistics_.reset();
+		}
+
+	protected:
+		/**
+		 * Inserts a node created from given arguments if a given key
+		 * is not yet present, the arguments are forwarded to the node
+		 * only once the key is known to be new.
+		 * Returns the node with the key and true if it was inserted.
+		 */
+		template<typename K, typename... Args>
+		std::pair<handle, bool> insert_(const K& key, Args&&... args)
+		{
+			if(root_ == storage_type::null)
+			{
+				root_ = storage_.allocate(std::forward<Args>(args)...);
+				size_ = 1;
+				return {root_, true};
+			}
+
+			splay_closest_(key);
+
+			auto order = utils::compare(comparator_, storage_.node(root_), key);
+			if(order == 0)
+				return {root_, false}; // Already present.
+
+			// No references are held while allocating, an array of nodes can grow.
+			auto node = storage_.allocate(std::forward<Args>(args)...);
+			attach_(node, order);
+			return {node, true};
+		}
+
+		/**
+		 * Looks up a given key like find.
+		 * Returns the node with the key (null if it is not present).
+		 */
+		template<typename K>
+		handle find_(const K& key)
+		{
+			auto&& lookup = utils::lookup_key<T, Comparator>(key);
+			auto node = access_(lookup);
+
+			if(node != storage_type::null && utils::compare(comparator_, storage_.node(node), lookup) == 0)
+				return node;
+			else
+				return storage_type::null;
+		}
+
+		/**
+		 * Returns the node a given handle refers to.
+		 */
+		node_type& node_(handle node)
+		{
+			return storage_.node(node);
+		}
+
+	private:
+		/**
+		 * Constructor used by split.
+		 * Param: Root of the new tree.
+		 * Param: Comparator of the split tree.
+		 * Param: Storage whose memory the nodes use.
+		 */
+		SplayTree(handle root, const Comparator& comparator,
+				  const storage_type& storage)
+			: root_{root}, comparator_{comparator},
+			  storage_{storage}, find_length_{},
+			  size_{root != storage_type::null ? unknown_size_ : std::size_t{}}
+		{ /* DUMMY BODY */ }
+
+		/**
+		 * Makes a given new node a son of the root, the node takes
+		 * over the subtree of the root on the side given by the
+		 * result of comparing the root to its key.
+		 */
+		void attach_(handle tmp, int order)
+		{
+			if(size_ != unknown_size_)
+				++size_;
+			if(order < 0)
+			{
+				storage_.right(tmp) = storage_.right(root_);
+				storage_.right(root_) = tmp;
+				utils::set_parent(storage_, tmp, root_);
+				utils::set_parent(storage_, storage_.right(tmp), tmp);
+			}
+			else
+			{
+				storage_.left(tmp) = storage_.left(root_);
+				storage_.left(root_) = tmp;
+				utils::set_parent(storage_, tmp, root_);
+				utils::set_parent(storage_, storage_.left(tmp), tmp);
+			}
+			utils::update(storage_, tmp);
+			utils::update(storage_, root_);
+		}
+
+		/**
+		 * Root node of the splay tree.
+		 */
+		handle root_{storage_type::null};
+
+		/**
+		 * Comparator used to navigate the tree on
+		 * insert/find.
+		 */
+		Comparator comparator_;
+
+		/**
+		 * Storage of the nodes.
+		 */
+		storage_type storage_;
+
+		/**
+		 * Returns true if a given node and its two
+		 * subtrees are valid binary search tree (with
+		 * correct subtree sizes).
+		 */
+		bool validate_(handle node) const
+		{
+			if(node == storage_type::null)
+				return true;
+
+			auto left = storage_.left(node);
+			auto right = storage_.right(node);
+			const auto& key = storage_.node(node).key;
+			if(left != storage_type::null && utils::compare(comparator_, storage_.node(left), key) > 0)
+				return false;
+			if(right != storage_type::null && utils::compare(comparator_, storage_.node(right), key) < 0)
+				return false;
+			if constexpr(utils::has_size<node_type>::value)
+			{
+				auto size = 1 + utils::subtree_size(storage_, left) + utils::subtree_size(storage_, right);
+				if(storage_.node(node).size != size)
+					return false;
+			}
+
+			return validate_(right) && validate_(left);
+		}
+
+		/**
+		 * Moves the node whose key is the closest to a given
+		 * key to the root, either by a single top-down pass
+		 * or by a search followed by a bottom-up splay.
+		 */
+		template<typename K>
+		void splay_closest_(const K& key)
+		{
+			if constexpr(SplayPolicy::top_down)
+				find_length_ = SplayPolicy::splay(storage_, root_, key, comparator_, statistics_);
+			else
+				SplayPolicy::splay(storage_, find_node_with_closest_key_(key), root_, statistics_);
+			statistics_.search(find_length_);
+		}
+
+		/**
+		 * Looks up the node whose key is the closest to a given key.
+		 * Policies that splay partially restructure the tree only as
+		 * they see fit for lookups, so the node does not have to end
+		 * up at the root.
+		 * Returns the node (null if the tree is empty).
+		 */
+		template<typename K>
+		handle access_(const K& key)
+		{
+			if constexpr(utils::splays_partially<SplayPolicy>::value)
+			{
+				auto node = find_node_with_closest_key_(key);
+				SplayPolicy::access(storage_, node, root_, find_length_, size(), policy_state_, statistics_);
+				statistics_.search(find_length_);
+				return node;
+			}
+			else
+			{
+				splay_closest_(key);
+				return root_;
+			}
+		}
+
+		/**
+		 * Returns the number of nodes in a given subtree.
+		 */
+		std::size_t count_(handle node) const
+		{
+			std::size_t count{};
+			std::vector<handle> stack{};
+			if(node != storage_type::null)
+				stack.push_back(node);
+
+			while(!stack.empty())
+			{ // Iteratively, degenerate trees are too deep for recursion.
+				node = stack.back();
+				stack.pop_back();
+				++count;
+
+				if(storage_.left(node) != storage_type::null)
+					stack.push_back(storage_.left(node));
+				if(storage_.right(node) != storage_type::null)
+					stack.push_back(storage_.right(node));
+			}
+
+			return count;
+		}
+
+		/**
+		 * Joins two subtrees whose keys are all smaller (left)
+		 * or all larger (right) than the other subtree's keys
+		 * by splaying the maximum of the left one to its root
+		 * and hanging the right one under it.
+		 * Returns the root of the joined tree.
+		 */
+		handle join_(handle left, handle right)
+		{
+			utils::set_parent(storage_, right, storage_type::null);
+			if(left == storage_type::null)
+				return right;
+			utils::set_parent(storage_, left, storage_type::null);
+
+			splay_max_(left);
+			storage_.right(left) = right;
+			utils::set_parent(storage_, right, left);
+			utils::update(storage_, left);
+
+			return left;
+		}
+
+		/**
+		 * Builds a balanced subtree from a given number of sorted keys,
+		 * the keys are consumed in order, so the iterator ends up
+		 * past the last key of the subtree.
+		 * Returns the root of the subtree.
+		 */
+		template<typename Iterator>
+		handle build_sorted_(Iterator& it, std::size_t count)
+		{
+			if(count == 0)
+				return storage_type::null;
+
+			auto left = build_sorted_(it, count / 2);
+			auto node = storage_.allocate(*it);
+			++it;
+			auto right = build_sorted_(it, count - count / 2 - 1);
+
+			storage_.left(node) = left;
+			storage_.right(node) = right;
+			utils::set_parent(storage_, left, node);
+			utils::set_parent(storage_, right, node);
+			utils::update(storage_, node);
+
+			return node;
+		}
+
+		/**
+		 * Detaches all keys greater than or equal to a given key
+		 * from the tree and returns the root of the detached subtree.
+		 */
+		handle split_(const T& key)
+		{
+			if(root_ == storage_type::null)
+				return storage_type::null;
+
+			splay_closest_(key);
+
+			handle right{storage_type::null};
+			if(comparator_(storage_.node(root_), key))
+			{
+				right = storage_.right(root_);
+				storage_.right(root_) = storage_type::null;
+				utils::update(storage_, root_);
+			}
+			else
+			{
+				right = root_;
+				root_ = storage_.left(root_);
+				storage_.left(right) = storage_type::null;
+				utils::update(storage_, right);
+				utils::set_parent(storage_, root_, storage_type::null);
+			}
+			utils::set_parent(storage_, right, storage_type::null);
+
+			return right;
+		}
+
+		/**
+		 * Propagates the node with the minimal key to the
+		 * root of a given (non-empty) subtree.
+		 */
+		void splay_min_(handle& root)
+		{
+			auto min = leftmost_(root);
+			if constexpr(SplayPolicy::top_down)
+				SplayPolicy::splay(storage_, root, storage_.node(min).key, comparator_, statistics_);
+			else
+				SplayPolicy::splay(storage_, min, root, statistics_);
+		}
+
+		/**
+		 * Propagates the node with the maximal key to the
+		 * root of a given (non-empty) subtree.
+		 */
+		void splay_max_(handle& root)
+		{
+			auto max = rightmost_(root);
+			if constexpr(SplayPolicy::top_down)
+				SplayPolicy::splay(storage_, root, storage_.node(max).key, comparator_, statistics_);
+			else
+				SplayPolicy::splay(storage_, max, root, statistics_);
+		}
+
+		/**
+		 * Returns the number of keys less than (or equal to if
+		 * a given flag is set) a given key. The key is looked up
+		 * and the position of the found node is computed from the
+		 * sizes on its path to the root, which is empty unless the
+		 * policy splays only partially.
+		 */
+		template<typename K>
+		std::size_t rank_(const K& key, bool inclusive)
+		{
+			static_assert(utils::has_size<node_type>::value, "Order statistics need SizedNodes.");
+			auto node = access_(key);
+			if(node == storage_type::null)
+				return std::size_t{};
+
+			auto order = utils::compare(comparator_, storage_.node(node), key);
+			std::size_t rank = utils::subtree_size(storage_, storage_.left(node))
+							   + (order < 0 || (inclusive && order == 0));
+			if constexpr(utils::has_parent<node_type>::value)
+			{
+				for(auto parent = storage_.parent(node); parent != storage_type::null;
+					node = parent, parent = storage_.parent(node))
+				{
+					if(storage_.right(parent) == node)
+						rank += 1 + utils::subtree_size(storage_, storage_.left(parent));
+				}
+			}
+
+			return rank;
+		}
+
+		/**
+		 * Returns the node with the smallest key in
+		 * a given (non-empty) subtree.
+		 */
+		handle leftmost_(handle node) const
+		{
+			while(storage_.left(node) != storage_type::null)
+				node = storage_.left(node);
+
+			return node;
+		}
+
+		/**
+		 * Returns the node with the greatest key in
+		 * a given (non-empty) subtree.
+		 */
+		handle rightmost_(handle node) const
+		{
+			while(storage_.right(node) != storage_type::null)
+				node = storage_.right(node);
+
+			return node;
+		}
+
+		/**
+		 * Returns the node with the next greater key (null if there
+		 * is none), walks up the tree using the parent pointers.
+		 */
+		handle successor_(handle node) const
+		{
+			if(storage_.right(node) != storage_type::null)
+				return leftmost_(storage_.right(node));
+
+			auto parent = storage_.parent(node);
+			while(parent != storage_type::null && storage_.right(parent) == node)
+			{
+				node = parent;
+				parent = storage_.parent(node);
+			}
+
+			return parent;
+		}
+
+		/**
+		 * Returns the node with the next smaller key (null if there
+		 * is none), walks up the tree using the parent pointers.
+		 */
+		handle predecessor_(handle node) const
+		{
+			if(storage_.left(node) != storage_type::null)
+				return rightmost_(storage_.left(node));
+
+			auto parent = storage_.parent(node);
+			while(parent != storage_type::null && storage_.left(parent) == node)
+			{
+				node = parent;
+				parent = storage_.parent(node);
+			}
+
+			return parent;
+		}
+
+		/**
+		 * Finds the node whose key is the closest to a given
+		 * key, using a single three-way comparison per level.
+		 */
+		template<typename K>
+		handle find_node_with_closest_key_(const K& key)
+		{
+			return find_node_with_closest_key_(root_, key);
+		}
+
+		/**
+		 * Finds the node of a given subtree whose key is the closest
+		 * to a given key, see above.
+		 */
+		template<typename K>
+		handle find_node_with_closest_key_(handle root, const K& key)
+		{
+			find_length_ = std::size_t{};
+
+			auto current_node = root;
+			auto prev_node = root;
+
+			while(current_node != storage_type::null)
+			{
+				prev_node = current_node;
+				auto& node = storage_.node(current_node);
+				auto order = utils::compare(comparator_, node, key);
+				if(order == 0)
+					return current_node;
+				else if(order < 0)
+					current_node = node.right;
+				else
+					current_node = node.left;
+				++find_length_;
+			}
+
+			return prev_node;
+		}
+
+		/**
+		 * Prints a single node and its subtree.
+		 */
+		std::string print_(handle node) const
+		{
+			if(node != storage_type::null)
+			{
+				/**
+				 * And then God said "Let there be Lisp!", and he
+				 * saw it good.
+				 */
+				auto left = storage_.left(node);
+				auto right = storage_.right(node);
+				return utils::to_string(storage_.node(node).key) +
+					   (left != storage_type::null || right != storage_type::null ? " " : "") +
+					   (left != storage_type::null ? "L(" + print_(left) + ")" : "") +
+					   (right != storage_type::null ? "R(" + print_(right) + ")" : "");
+			}
+			else
+				return "";
+		}
+
+		/**
+		 * Destroys all nodes of the tree, arenas free all
+		 * nodes at once, so the tree only has to be walked
+		 * if the keys need to be destroyed or if other trees
+		 * share the arena (and can reuse the nodes).
+		 */
+		void destroy_()
+		{
+			constexpr bool walk = !storage_type::releases_in_bulk
+				|| !std::is_trivially_destructible<node_type>::value;
+
+			if(walk || !storage_.exclusive())
+				delete_(root_);
+		}
+
+		/**
+		 * Deletes a given node and its subtree.
+		 * (Deleting root_ effectively deallocates the tree.)
+		 * Left sons are rotated up until the node has none, then
+		 * it is deleted and its right son follows, so the walk needs
+		 * neither recursion nor a stack, as splay trees can be very deep.
+		 */
+		void delete_(handle node)
+		{
+			while(node != storage_type::null)
+			{
+				auto left = storage_.left(node);
+				if(left != storage_type::null)
+				{ // Rotate right, the parent links are not needed anymore.
+					storage_.left(node) = storage_.right(left);
+					storage_.right(left) = node;
+					node = left;
+				}
+				else
+				{
+					auto right = storage_.right(node);
+					storage_.deallocate(node);
+					node = right;
+				}
+			}
+		}
+
+		/**
+		 * Variable keeping track of the length of the last traversal.
+		 */
+		std::size_t find_length_{};
+
+		/**
+		 * Statistics about the operations of the tree.
+		 */
+		Statistics statistics_{};
+
+		/**
+		 * Order in which the keys of a batched find are looked up,
+		 * kept to avoid allocating for every batch.
+		 */
+		std::vector<std::size_t> order_{};
+
+		/**
+		 * Marks the number of keys as unknown (after a split).
+		 */
+		static constexpr std::size_t unknown_size_{std::numeric_limits<std::size_t>::max()};
+
+		/**
+		 * Number of keys in the tree, or unknown_size_.
+		 */
+		mutable std::size_t size_{};
+
+		/**
+		 * State of a policy that splays partially.
+		 */
+		typename utils::splays_partially<SplayPolicy>::state policy_state_{};
+};
+
+/**
+ * Splay tree whose nodes keep the sizes of their subtrees, which
+ * allows rank, select and count_in_range queries in O(log n) amortized.
+ */
+template<
+	typename T, typename SplayPolicy,
+	typename Comparator = utils::SplayComparator<T>,
+	template<typename> class Allocator = SlabAllocator,
+	typename Statistics = NoSplayStatistics
+>
+using OrderStatisticSplayTree = SplayTree<T, SplayPolicy, Comparator, Allocator, Statistics, SizedNode>;
+
+/**
+ * Splay tree whose nodes keep the aggregates of their subtrees (see
+ * AggregateNode), which allows aggregate(low, high) queries (e.g. range
+ * sums or minima) in O(log n) amortized.
+ */
+template<
+	typename T, typename SplayPolicy, typename Aggregate,
+	typename Comparator = utils::SplayComparator<T>,
+	template<typename> class Allocator = SlabAllocator,
+	typename Statistics = NoSplayStatistics
+>
+using AggregateSplayTree = SplayTree<
+	T, SplayPolicy, Comparator, Allocator, Statistics,
+	AggregateNodes<Aggregate>::template type
+>;
+
+/**
+ * Splay tree that stores its nodes compactly in a single array and
+ * links them by 32-bit indices (see IndexedNodeStorage), so it can hold
+ * less than 4G keys. With small keys a node takes half of the memory of
+ * a Node, and more of the nodes on a search path share cache lines.
+ */
+template<
+	typename T, typename SplayPolicy,
+	typename Comparator = utils::SplayComparator<T>,
+	typename Statistics = NoSplayStatistics
+>
+using CompactSplayTree = SplayTree<T, SplayPolicy, Comparator, IndexedNodeStorage, Statistics, CompactNode>;
+
+/**
+ * Class that represents a splay tree that maps keys of a given
+ * type to values of a given type and uses a given splay policy.
+ * Lookups return pointers to the stored values, so nothing is copied
+ * and a miss (nullptr) cannot be mistaken for a stored value. The map
+ * is a SplayTree whose nodes keep the values (see MapNode).
+ */
+template<
+	typename K, typename V, typename SplayPolicy,
+	typename Comparator = utils::SplayComparator<K>,
+	template<typename> class Allocator = SlabAllocator
+>
+class SplayMap
+	: private SplayTree<
+		K, SplayPolicy, Comparator, Allocator,
+		NoSplayStatistics, MapNodes<V>::template type
+	>
+{
+	/**
+	 * Tree that keeps the keys and the values.
+	 */
+	using tree_type = SplayTree<
+		K, SplayPolicy, Comparator, Allocator,
+		NoSplayStatistics, MapNodes<V>::template type
+	>;
+
+	public:
+		/**
+		 * Type of the nodes this map consists of.
+		 */
+		using typename tree_type::node_type;
+
+		/**
+		 * Removes the given key and its value from the map,
+		 * see SplayTree::erase.
+		 */
+		using tree_type::erase;
+
+		/**
+		 * Returns true if this map contains
+		 * this key already.
+		 */
+		using tree_type::contains;
+
+		/**
+		 * Removes all keys from the map, see SplayTree::clear.
+		 */
+		using tree_type::clear;
+
+		/**
+		 * Makes sure the map can hold a given number of keys
+		 * without allocating more memory.
+		 */
+		using tree_type::reserve;
+
+		/**
+		 * Returns the length of the last find traversal.
+		 */
+		using tree_type::length_of_last_find;
+
+		/**
+		 * Constructor.
+		 */
+		SplayMap() = default;
+
+		/**
+		 * Returns a pointer to the value associated with a given
+		 * key or nullptr if the key is not present.
+		 */
+		template<typename U = K>
+		V* find(const U& key)
+		{
+			auto node = this->find_(key);
+			if(node != tree_type::storage_type::null)
+				return &this->node_(node).value;
+			else
+				return nullptr;
+		}
+
+		/**
+		 * Constructs a value from given arguments and associates it
+		 * with a given key if that key is not yet present in the map.
+		 * Returns a pointer to the value associated with the key and
+		 * true if the value was inserted.
+		 */
+		template<typename... Args>
+		std::pair<V*, bool> try_emplace(const K& key, Args&&... args)
+		{
+			auto [node, inserted] = this->insert_(key, key, std::forward<Args>(args)...);
+			return {&this->node_(node).value, inserted};
+		}
+
+		/**
+		 * Associates a given value with a given key, replacing
+		 * the value if the key is already present.
+		 * Returns a pointer to the value associated with the key and
+		 * true if the value was inserted.
+		 */
+		template<typename M>
+		std::pair<V*, bool> insert_or_assign(const K& key, M&& value)
+		{
+			auto res = try_emplace(key, std::forward<M>(value));
+			if(!res.second)
+				*res.first = std::forward<M>(value);
+
+			return res;
+		}
+};
+
+/**
+ * Class that represents a splay tree that can be shared between threads.
+ * The key space is partitioned (using the comparator) into ranges, every range
+ * is stored in an independent splay tree (a shard) with its own lock, so
+ * threads accessing different ranges do not wait for each other. The shard
+ * boundaries can be changed at any time, the shards are then joined and
+ * split again without copying any nodes.
+ */
+template<
+	typename T, typename SplayPolicy,
+	typename Comparator = utils::SplayComparator<T>,
+	template<typename> class Allocator = SlabAllocator
+>
+class ShardedSplayTree
+{
+	public:
+		/**
+		 * Type of the trees the keys are stored in.
+		 */
+		using tree_type = SplayTree<T, SplayPolicy, Comparator, Allocator>;
+
+		/**
+		 * Constructor.
+		 * Param: Boundaries of the shards, shard i contains the keys
+		 *        in [boundaries[i - 1], boundaries[i]), there is one
+		 *        more shard than boundaries.
+		 * Param: Comparator that orders the keys.
+		 */
+		ShardedSplayTree(std::vector<T> boundaries = std::vector<T>{},
+						 Comparator comparator = Comparator{})
+			: comparator_{std::move(comparator)}
+		{
+			assign_boundaries_(std::move(boundaries));
+		}
+
+		/**
+		 * The shards own their locks.
+		 */
+		ShardedSplayTree(const ShardedSplayTree&) = delete;
+		ShardedSplayTree& operator=(const ShardedSplayTree&) = delete;
+
+		/**
+		 * Inserts the given key into the tree
+		 * if that key is not yet present in the tree.
+		 */
+		void insert(const T& key)
+		{
+			std::shared_lock<std::shared_mutex> shards_lock{shards_mutex_};
+			auto& shard = *shards_[shard_of_(key)];
+			std::lock_guard<std::mutex> lock{shard.mutex};
+			shard.tree.insert(key);
+		}
+
+		/**
+		 * Removes the given key from the tree.
+		 * Returns true if the key was present.
+		 */
+		bool erase(const T& key)
+		{
+			std::shared_lock<std::shared_mutex> shards_lock{shards_mutex_};
+			auto& shard = *shards_[shard_of_(key)];
+			std::lock_guard<std::mutex> lock{shard.mutex};
+			return shard.tree.erase(key);
+		}
+
+		/**
+		 * Returns true if this tree contains
+		 * this key already.
+		 */
+		bool contains(const T& key)
+		{
+			std::shared_lock<std::shared_mutex> shards_lock{shards_mutex_};
+			auto& shard = *shards_[shard_of_(key)];
+			std::lock_guard<std::mutex> lock{shard.mutex};
+			return shard.tree.contains(key);
+		}
+
+		/**
+		 * Inserts a batch of keys, the lock of every shard
+		 * is taken only once.
+		 * Param: Keys to insert.
+		 * Param: Number of the keys.
+		 */
+		void insert_many(const T* keys, std::size_t count)
+		{
+			for_each_shard_(keys, count, [&](tree_type& tree, const std::size_t* indices, std::size_t n){
+				for(std::size_t i = 0; i < n; ++i)
+					tree.insert(keys[indices[i]]);
+			});
+		}
+
+		/**
+		 * Removes a batch of keys, the lock of every shard
+		 * is taken only once.
+		 * Returns the number of keys that were present.
+		 * Param: Keys to remove.
+		 * Param: Number of the keys.
+		 */
+		std::size_t erase_many(const T* keys, std::size_t count)
+		{
+			std::size_t erased{};
+			for_each_shard_(keys, count, [&](tree_type& tree, const std::size_t* indices, std::size_t n){
+				for(std::size_t i = 0; i < n; ++i)
+					erased += tree.erase(keys[indices[i]]);
+			});
+
+			return erased;
+		}
+
+		/**
+		 * Looks up a batch of keys, the lock of every shard is
+		 * taken only once and the keys of a shard are looked up
+		 * together (see SplayTree::find_many). The results are
+		 * stored in the original order.
+		 * Param: Keys to look up.
+		 * Param: Number of the keys.
+		 * Param: Array of at least count results.
+		 */
+		void find_many(const T* keys, std::size_t count, FindResult* results)
+		{
+			std::vector<T> shard_keys{};
+			std::vector<FindResult> shard_results{};
+			for_each_shard_(keys, count, [&](tree_type& tree, const std::size_t* indices, std::size_t n){
+				shard_keys.resize(n);
+				shard_results.resize(n);
+				for(std::size_t i = 0; i < n; ++i)
+					shard_keys[i] = keys[indices[i]];
+
+				tree.find_many(shard_keys.data(), n, shard_results.data());
+				for(std::size_t i = 0; i < n; ++i)
+					results[indices[i]] = shard_results[i];
+			});
+		}
+
+		/**
+		 * Changes the boundaries of the shards (see the constructor),
+		 * the number of shards can change as well. All shards are
+		 * joined into a single tree which is then split at the new
+		 * boundaries, so no keys are copied.
+		 */
+		void rebalance(std::vector<T> boundaries)
+		{
+			std::unique_lock<std::shared_mutex> shards_lock{shards_mutex_};
+
+			tree_type all{comparator_};
+			for(auto& shard : shards_)
+				all.join(shard->tree);
+
+			assign_boundaries_(std::move(boundaries));
+			for(auto i = boundaries_.size(); i > 0; --i)
+			{
+				auto part = all.split(boundaries_[i - 1]);
+				shards_[i]->tree.join(part);
+			}
+			shards_[0]->tree.join(all);
+		}
+
+		/**
+		 * Changes the boundaries of the shards so that a given sample
+		 * of keys (e.g. recently accessed ones) is split evenly among
+		 * a given number of shards.
+		 * Param: Sample of keys.
+		 * Param: Number of the keys.
+		 * Param: Number of the shards.
+		 */
+		void rebalance(const T* keys, std::size_t count, std::size_t shard_count)
+		{
+			std::vector<T> sample(keys, keys + count);
+			std::sort(sample.begin(), sample.end(), less_());
+
+			std::vector<T> boundaries{};
+			for(std::size_t i = 1; i < shard_count && !sample.empty(); ++i)
+				boundaries.push_back(sample[sample.size() * i / shard_count]);
+
+			rebalance(std::move(boundaries));
+		}
+
+		/**
+		 * Returns the boundaries of the shards.
+		 */
+		std::vector<T> boundaries() const
+		{
+			std::shared_lock<std::shared_mutex> shards_lock{shards_mutex_};
+			return boundaries_;
+		}
+
+		/**
+		 * Returns the number of the shards.
+		 */
+		std::size_t shard_count() const
+		{
+			std::shared_lock<std::shared_mutex> shards_lock{shards_mutex_};
+			return shards_.size();
+		}
+
+		/**
+		 * Returns true if every shard is a valid binary search
+		 * tree and contains only keys from its range. The shards
+		 * are only read, so other threads can keep using them.
+		 */
+		bool validate() const
+		{
+			std::shared_lock<std::shared_mutex> shards_lock{shards_mutex_};
+
+			bool res{true};
+			for(std::size_t i = 0; i < shards_.size() && res; ++i)
+			{
+				std::lock_guard<std::mutex> lock{shards_[i]->mutex};
+				const auto& tree = shards_[i]->tree;
+				res = tree.validate();
+				if(tree.empty())
+					continue;
+				if(i > 0)
+					res = res && !utils::less(comparator_, *tree.min(), boundaries_[i - 1]);
+				if(i < boundaries_.size())
+					res = res && utils::less(comparator_, *tree.max(), boundaries_[i]);
+			}
+
+			return res;
+		}
+
+	private:
+		/**
+		 * A tree with its lock.
+		 */
+		struct Shard
+		{
+			/**
+			 * Constructor.
+			 * Param: Comparator of the tree.
+			 */
+			explicit Shard(const Comparator& comparator)
+				: tree{comparator}
+			{ /* DUMMY BODY */ }
+
+			std::mutex mutex{};
+			tree_type tree;
+		};
+
+		/**
+		 * Returns a function object that compares two keys
+		 * using the comparator of the tree.
+		 */
+		auto less_() const
+		{
+			return [this](const T& a, const T& b){ return utils::less(comparator_, a, b); };
+		}
+
+		/**
+		 * Sorts and deduplicates given boundaries, sets them as
+		 * the boundaries and creates empty shards for them.
+		 */
+		void assign_boundaries_(std::vector<T> boundaries)
+		{
+			auto less = less_();
+			std::sort(boundaries.begin(), boundaries.end(), less);
+			boundaries.erase(std::unique(boundaries.begin(), boundaries.end(), [&less](const T& a, const T& b){
+				return !less(a, b);
+			}), boundaries.end());
+			boundaries_ = std::move(boundaries);
+
+			shards_.clear();
+			for(std::size_t i = 0; i <= boundaries_.size(); ++i)
+				shards_.push_back(std::make_unique<Shard>(comparator_));
+		}
+
+		/**
+		 * Returns the index of the shard that contains a given key.
+		 */
+		std::size_t shard_of_(const T& key) const
+		{
+			return static_cast<std::size_t>(
+				std::upper_bound(boundaries_.begin(), boundaries_.end(), key, less_()) - boundaries_.begin()
+			);
+		}
+
+		/**
+		 * Groups a batch of keys by their shards and calls a given function
+		 * for every shard with keys while holding its lock.
+		 * Param: Keys of the batch.
+		 * Param: Number of the keys.
+		 * Param: Function called with the tree of a shard, the indices of
+		 *        its keys (in their original order) and their number.
+		 */
+		template<typename Function>
+		void for_each_shard_(const T* keys, std::size_t count, Function&& function)
+		{
+			std::shared_lock<std::shared_mutex> shards_lock{shards_mutex_};
+
+			// Counting sort of the key indices by their shards.
+			std::vector<std::size_t> shard_of(count);
+			std::vector<std::size_t> begin(shards_.size() + 1);
+			for(std::size_t i = 0; i < count; ++i)
+			{
+				shard_of[i] = shard_of_(keys[i]);
+				++begin[shard_of[i] + 1];
+			}
+			for(std::size_t i = 1; i < begin.size(); ++i)
+				begin[i] += begin[i - 1];
+
+			std::vector<std::size_t> indices(count);
+			auto next = begin;
+			for(std::size_t i = 0; i < count; ++i)
+				indices[next[shard_of[i]]++] = i;
+
+			for(std::size_t i = 0; i < shards_.size(); ++i)
+			{
+				if(begin[i] == begin[i + 1])
+					continue;
+
+				std::lock_guard<std::mutex> lock{shards_[i]->mutex};
+				function(shards_[i]->tree, indices.data() + begin[i], begin[i + 1] - begin[i]);
+			}
+		}
+
+		/**
+		 * Comparator that orders the keys, the shards
+		 * have its copies.
+		 */
+		Comparator comparator_;
+
+		/**
+		 * Boundaries of the shards.
+		 */
+		std::vector<T> boundaries_{};
+
+		/**
+		 * The shards, they are not stored directly so that
+		 * their locks never move.
+		 */
+		std::vector<std::unique_ptr<Shard>> shards_{};
+
+		/**
+		 * Lock of the boundaries and the list of shards, taken
+		 * exclusively only when they change.
+		 */
+		mutable std::shared_mutex shards_mutex_{};
+};
+
+/**
+ * Auxiliary class implementing rotations on splay trees, this approach was
+ * chosen to avoid unnecessary use of inheritance. The rotations work on
+ * any node storage (see PointerNodeStorage and IndexedNodeStorage), plain
+ * nodes are rotated through the pointer storage. The two rewired nodes
+ * are updated (see utils::update), so the sizes of SizedNodes and the
+ * aggregates of AggregateNodes stay correct.
+ * Note: Comments talking about movement, root and pivot, alpha, beta and gamma
+ *       are all refering to this gif:
+ *       https://upload.wikimedia.org/wikipedia/commons/3/31/Tree_rotation_animation_250x250.gif
+ *       This is because, to this day, tree rotations confuse me.
+ *       (I know, I know, shameful.)
+ */
+template<typename T>
+struct SplayTreeRotator
+{
+	/**
+	 * Performs a left rotation around the given node.
+	 * Param: Root of the rotated subtree.
+	 * Param: Root of the entire tree.
+	 */
+	template<typename N>
+	static void rotate_left(N* node, N** tree_root)
+	{
+		NoSplayStatistics statistics{};
+		rotate_left(node, tree_root, statistics);
+	}
+
+	/**
+	 * Performs a left rotation around the given node and counts it.
+	 * Param: Root of the rotated subtree.
+	 * Param: Root of the entire tree.
+	 * Param: Statistics the rotation is recorded in.
+	 */
+	template<typename N, typename Statistics>
+	static void rotate_left(N* node, N** tree_root, Statistics& statistics)
+	{
+		if(!tree_root || !(*tree_root))
+			return;
+
+		PointerNodeStorage<N> storage{};
+		rotate_left(storage, node, *tree_root, statistics);
+	}
+
+	/**
+	 * Performs a left rotation around the given node of a given
+	 * storage and counts it.
+	 * Param: Storage of the nodes.
+	 * Param: Root of the rotated subtree.
+	 * Param: Root of the entire tree.
+	 * Param: Statistics the rotation is recorded in.
+	 */
+	template<typename S, typename Statistics>
+	static void rotate_left(S& storage, typename S::handle node,
+							typename S::handle& tree_root, Statistics& statistics)
+	{
+		if(node == S::null)
+			return;
+
+		auto right = storage.right(node); // Pivot.
+		if(right != S::null)
+		{
+			// Beta horizontal movement.
+			if(storage.left(right) != S::null)
+				storage.parent(storage.left(right)) = node;
+			storage.right(node) = storage.left(right);
+
+			// Swap of root and pivot.
+			storage.left(right) = node;
+			storage.parent(right) = storage.parent(node);
+		}
+
+		// Finnish the swap of root and pivot,
+		// i.e. update root or children of root's
+		// parent.
+		if(storage.parent(node) == S::null)
+			tree_root = right;
+		else if(utils::is_left_son(storage, node))
+			storage.left(storage.parent(node)) = right;
+		else
+			storage.right(storage.parent(node)) = right;
+		storage.parent(node) = right;
+		statistics.rotation();
+
+		// The pivot is now above the root.
+		utils::update(storage, node);
+		if(right != S::null)
+			utils::update(storage, right);
+	}
+
+	/**
+	 * Performs a right rotation around the given node.
+	 * Param: Root of the rotated subtree.
+	 * Param: Root of the entire tree.
+	 */
+	template<typename N>
+	static void rotate_right(N* node, N** tree_root)
+	{
+		NoSplayStatistics statistics{};
+		rotate_right(node, tree_root, statistics);
+	}
+
+	/**
+	 * Performs a right rotation around the given node and counts it.
+	 * Param: Root of the rotated subtree.
+	 * Param: Root of the entire tree.
+	 * Param: Statistics the rotation is recorded in.
+	 */
+	template<typename N, typename Statistics>
+	static void rotate_right(N* node, N** tree_root, Statistics& statistics)
+	{
+		if(!tree_root)
+			return;
+
+		PointerNodeStorage<N> storage{};
+		rotate_right(storage, node, *tree_root, statistics);
+	}
+
+	/**
+	 * Performs a right rotation around the given node of a given
+	 * storage and counts it.
+	 * Param: Storage of the nodes.
+	 * Param: Root of the rotated subtree.
+	 * Param: Root of the entire tree.
+	 * Param: Statistics the rotation is recorded in.
+	 */
+	template<typename S, typename Statistics>
+	static void rotate_right(S& storage, typename S::handle node,
+							 typename S::handle& tree_root, Statistics& statistics)
+	{
+		if(node == S::null)
+			return;
+	
+		auto left = storage.left(node); // Pivot.
+		if(left != S::null)
+		{
+			// Beta horizontal movement.
+			if(storage.right(left) != S::null)
+				storage.parent(storage.right(left)) = node;
+			storage.left(node) = storage.right(left);
+
+			// Swap of root and pivot.
+			storage.right(left) = node;
+			storage.parent(left) = storage.parent(node);
+		}
+
+		// Finnish the swap of root and pivot,
+		// i.e. update root or children of root's
+		// parent.
+		if(storage.parent(node) == S::null)
+			tree_root = left;
+		else if(utils::is_left_son(storage, node))
+			storage.left(storage.parent(node)) = left;
+		else
+			storage.right(storage.parent(node)) = left;
+		storage.parent(node) = left;
+		statistics.rotation();
+
+		// The pivot is now above the root.
+		utils::update(storage, node);
+		if(left != S::null)
+			utils::update(storage, left);
+	}
+};
+
+/**
+ * Standard implementation of the splay operation using the
+ * zig, zigzig and zigzag step during propagation.
+ */
+template<typename T>
+struct DoubleRotationSplayPolicy
+{
+	/**
+	 * Splays bottom-up once the node has been found.
+	 */
+	static constexpr bool top_down{false};
+
+	/**
+	 * Propagates a given node to the top of the tree.
+	 */
+	template<typename N>
+	static void splay(N* node, N** root)
+	{
+		NoSplayStatistics statistics{};
+		splay(node, root, statistics);
+	}
+
+	/**
+	 * Propagates a given node to the top of the tree and
+	 * records the steps in given statistics.
+	 */
+	template<typename N, typename Statistics>
+	static void splay(N* node, N** root, Statistics& statistics)
+	{
+		if(!node || !root)
+			return;
+
+		PointerNodeStorage<N> storage{};
+		splay(storage, node, *root, statistics);
+	}
+
+	/**
+	 * Propagates a given node of a given storage to the top of
+	 * the tree and records the steps in given statistics.
+	 */
+	template<typename S, typename Statistics>
+	static void splay(S& storage, typename S::handle node,
+					  typename S::handle& root, Statistics& statistics)
+	{
+		if(node == S::null || storage.parent(node) == S::null)
+			return;
+
+		using Rotator = SplayTreeRotator<T>;
+		while(storage.parent(node) != S::null)
+		{
+			auto parent = storage.parent(node);
+			if(utils::is_son_of_root(storage, node))
+			{ // Zig.
+				statistics.zig();
+				if(utils::is_left_son(storage, node))
+					Rotator::rotate_right(storage, parent, root, statistics);
+				else
+					Rotator::rotate_left(storage, parent, root, statistics);
+			}
+			else if(utils::is_left_son_of_left_son(storage, node))
+			{ // Zig-zig.
+				statistics.zig_zig();
+				Rotator::rotate_right(storage, storage.parent(parent), root, statistics);
+				Rotator::rotate_right(storage, storage.parent(node), root, statistics);
+			}
+			else if(utils::is_right_son_of_right_son(storage, node))
+			{ // Zig-zig 2: Zig-zig harder.
+				statistics.zig_zig();
+				Rotator::rotate_left(storage, storage.parent(parent), root, statistics);
+				Rotator::rotate_left(storage, storage.parent(node), root, statistics);
+			}
+			else if(utils::is_left_son_of_right_son(storage, node))
+			{ // Zig-zag.
+				statistics.zig_zag();
+				Rotator::rotate_right(storage, parent, root, statistics);
+				Rotator::rotate_left(storage, storage.parent(node), root, statistics);
+			
+			}
+			else if(utils::is_right_son_of_left_son(storage, node))
+			{ // Zig-zag 2: The Zigpocalypse.
+				statistics.zig_zag();
+				Rotator::rotate_left(storage, parent, root, statistics);
+				Rotator::rotate_right(storage, storage.parent(node), root, statistics);
+			}
+			else
+				DEBUG("Splay operation reached undefined state of nodes.");
+		}
+	}
+};
+
+/**
+ * Naive implementation of the splay operation using a sequence of simple
+ * rotations.
+ */
+template<typename T>
+struct NaiveSplayPolicy
+{
+	/**
+	 * Splays bottom-up once the node has been found.
+	 */
+	static constexpr bool top_down{false};
+
+	/**
+	 * Propagates a given node to the top of the tree.
+	 */
+	template<typename N>
+	static void splay(N* node, N** root)
+	{
+		NoSplayStatistics statistics{};
+		splay(node, root, statistics);
+	}
+
+	/**
+	 * Propagates a given node to the top of the tree and
+	 * records the steps in given statistics.
+	 */
+	template<typename N, typename Statistics>
+	static void splay(N* node, N** root, Statistics& statistics)
+	{
+		if(!node || !root)
+			return;
+
+		PointerNodeStorage<N> storage{};
+		splay(storage, node, *root, statistics);
+	}
+
+	/**
+	 * Propagates a given node of a given storage to the top of
+	 * the tree and records the steps in given statistics.
+	 */
+	template<typename S, typename Statistics>
+	static void splay(S& storage, typename S::handle node,
+					  typename S::handle& root, Statistics& statistics)
+	{
+		if(node == S::null || storage.parent(node) == S::null)
+			return;
+
+		while(storage.parent(node) != S::null)
+		{
+			statistics.zig();
+			if(utils::is_left_son(storage, node))
+				SplayTreeRotator<T>::rotate_right(storage, storage.parent(node), root, statistics);
+			else
+				SplayTreeRotator<T>::rotate_left(storage, storage.parent(node), root, statistics);
+		}
+	}
+};
+
+/**
+ * Simple top-down implementation of the splay operation, the tree
+ * is splayed during the search itself, so the path is walked only
+ * once and no parent pointers need to be maintained.
+ */
+template<typename T>
+struct TopDownSplayPolicy
+{
+	/**
+	 * Splays during the search, works on nodes without
+	 * the parent pointer.
+	 */
+	static constexpr bool top_down{true};
+
+	/**
+	 * Propagates the node whose key is the closest to a given
+	 * key to the top of the tree and returns the length of
+	 * the traversal.
+	 * Param: Root of the entire tree.
+	 * Param: Key that is being searched for.
+	 * Param: Comparator used to navigate the tree.
+	 */
+	template<typename N, typename Comparator, typename K = T>
+	static std::size_t splay(N** root, const K& key, const Comparator& comparator)
+	{
+		NoSplayStatistics statistics{};
+		return splay(root, key, comparator, statistics);
+	}
+
+	/**
+	 * Propagates the node whose key is the closest to a given
+	 * key to the top of the tree, records the steps in given
+	 * statistics and returns the length of the traversal.
+	 * Param: Root of the entire tree.
+	 * Param: Key that is being searched for.
+	 * Param: Comparator used to navigate the tree.
+	 * Param: Statistics the steps are recorded in.
+	 */
+	template<typename N, typename Comparator, typename Statistics, typename K = T>
+	static std::size_t splay(N** root, const K& key, const Comparator& comparator,
+							 Statistics& statistics)
+	{
+		if(!root)
+			return 0;
+
+		PointerNodeStorage<N> storage{};
+		return splay(storage, *root, key, comparator, statistics);
+	}
+
+	/**
+	 * Propagates the node of a given storage whose key is the
+	 * closest to a given key to the top of the tree, records
+	 * the steps in given statistics and returns the length of
+	 * the traversal.
+	 * Param: Storage of the nodes.
+	 * Param: Root of the entire tree.
+	 * Param: Key that is being searched for.
+	 * Param: Comparator used to navigate the tree.
+	 * Param: Statistics the steps are recorded in.
+	 */
+	template<typename S, typename Comparator, typename Statistics, typename K = T>
+	static std::size_t splay(S& storage, typename S::handle& root, const K& key,
+							 const Comparator& comparator, Statistics& statistics)
+	{
+		using handle = typename S::handle;
+		if(root == S::null)
+			return 0;
+
+		/**
+		 * Nodes smaller than the key are hung on the right spine
+		 * of the left tree, larger ones on the left spine of the
+		 * right tree. The hooks point to the slots the next node
+		 * will be linked into. Every node on the path is compared
+		 * with the key only once, the order of a child is kept
+		 * for the next step unless a rotation moved past it.
+		 */
+		handle left_tree{S::null};
+		handle right_tree{S::null};
+		handle* left_hook{&left_tree};
+		handle* right_hook{&right_tree};
+
+		auto node = root;
+		auto order = utils::compare(comparator, storage.node(node), key);
+		std::size_t length{};
+		std::size_t left_count{};
+		std::size_t right_count{};
+		while(order != 0)
+		{
+			++length;
+			if(order < 0)
+			{
+				if(storage.right(node) == S::null)
+					break;
+
+				auto child_order = utils::compare(comparator, storage.node(storage.right(node)), key);
+				if(child_order < 0)
+				{ // Zig-zig, rotate left.
+					auto right = storage.right(node);
+					storage.right(node) = storage.left(right);
+					storage.left(right) = node;
+					utils::update(storage, node);
+					node = right;
+					statistics.zig_zig();
+					statistics.rotation();
+
+					++length;
+					if(storage.right(node) == S::null)
+						break;
+				}
+				else
+					statistics.zig();
+
+				// Link left.
+				++left_count;
+				*left_hook = node;
+				left_hook = &storage.right(node);
+				node = storage.right(node);
+				order = child_order < 0 ? utils::compare(comparator, storage.node(node), key) : child_order;
+			}
+			else
+			{
+				if(storage.left(node) == S::null)
+					break;
+
+				auto child_order = utils::compare(comparator, storage.node(storage.left(node)), key);
+				if(child_order > 0)
+				{ // Zig-zig, rotate right.
+					auto left = storage.left(node);
+					storage.left(node) = storage.right(left);
+					storage.right(left) = node;
+					utils::update(storage, node);
+					node = left;
+					statistics.zig_zig();
+					statistics.rotation();
+
+					++length;
+					if(storage.left(node) == S::null)
+						break;
+				}
+				else
+					statistics.zig();
+
+				// Link right.
+				++right_count;
+				*right_hook = node;
+				right_hook = &storage.left(node);
+				node = storage.left(node);
+				order = child_order > 0 ? utils::compare(comparator, storage.node(node), key) : child_order;
+			}
+		}
+
+		// Assemble.
+		*left_hook = storage.left(node);
+		*right_hook = storage.right(node);
+		storage.left(node) = left_tree;
+		storage.right(node) = right_tree;
+		root = node;
+
+		if constexpr(utils::is_augmented<typename S::node_type>::value)
+		{ // The linked nodes have new sons.
+			using link = handle& (S::*)(handle);
+			update_spine_(storage, left_tree, left_count, static_cast<link>(&S::right));
+			update_spine_(storage, right_tree, right_count, static_cast<link>(&S::left));
+			utils::update(storage, node);
+		}
+
+		return length;
+	}
+
+	/**
+	 * Updates (see utils::update) the nodes on the spine of the left
+	 * (or right) tree assembled by the splay, each of them has a new son
+	 * on the spine, so they have to be updated from the bottom. The links
+	 * of the spine are reversed on the way down and restored on the way
+	 * up, so no extra memory is needed.
+	 * Param: Storage of the nodes.
+	 * Param: First node of the spine.
+	 * Param: Number of nodes on the spine.
+	 * Param: Link to the next node of the spine.
+	 */
+	template<typename S, typename Spine>
+	static void update_spine_(S& storage, typename S::handle node, std::size_t count, Spine spine)
+	{
+		auto previous = S::null;
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			auto next = (storage.*spine)(node);
+			(storage.*spine)(node) = previous;
+			previous = node;
+			node = next;
+		}
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			auto up = (storage.*spine)(previous);
+			(storage.*spine)(previous) = node;
+			utils::update(storage, previous);
+			node = previous;
+			previous = up;
+		}
+	}
+};
+
+/**
+ * Semi-splaying as described by Sleator and Tarjan, a lookup moves
+ * the node only about halfway to the root. In the zig-zig case only
+ * the parent is rotated and the splaying continues from it, which
+ * still roughly halves the depth of every node on the path, but with
+ * half of the rotations (and writes). Operations that change the tree
+ * splay all the way to the root.
+ */
+template<typename T>
+struct SemiSplayPolicy
+{
+	/**
+	 * Splays bottom-up once the node has been found.
+	 */
+	static constexpr bool top_down{false};
+
+	/**
+	 * The policy keeps no state in the trees.
+	 */
+	struct state
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Propagates a given node to the top of the tree.
+	 */
+	template<typename N>
+	static void splay(N* node, N** root)
+	{
+		DoubleRotationSplayPolicy<T>::splay(node, root);
+	}
+
+	/**
+	 * Propagates a given node to the top of the tree and
+	 * records the steps in given statistics.
+	 */
+	template<typename N, typename Statistics>
+	static void splay(N* node, N** root, Statistics& statistics)
+	{
+		DoubleRotationSplayPolicy<T>::splay(node, root, statistics);
+	}
+
+	/**
+	 * Propagates a given node of a given storage to the top of
+	 * the tree and records the steps in given statistics.
+	 */
+	template<typename S, typename Statistics>
+	static void splay(S& storage, typename S::handle node,
+					  typename S::handle& root, Statistics& statistics)
+	{
+		DoubleRotationSplayPolicy<T>::splay(storage, node, root, statistics);
+	}
+
+	/**
+	 * Semi-splays a given node after it has been looked up.
+	 * Param: The node.
+	 * Param: Root of the entire tree.
+	 * Param: Depth of the node.
+	 * Param: Number of nodes in the tree.
+	 * Param: State of the policy.
+	 * Param: Statistics the steps are recorded in.
+	 */
+	template<typename N, typename Statistics>
+	static void access(N* node, N** root, std::size_t depth, std::size_t size,
+					   state& policy_state, Statistics& statistics)
+	{
+		PointerNodeStorage<N> storage{};
+		access(storage, node, *root, depth, size, policy_state, statistics);
+	}
+
+	/**
+	 * Semi-splays a given node of a given storage after it
+	 * has been looked up.
+	 */
+	template<typename S, typename Statistics>
+	static void access(S& storage, typename S::handle node, typename S::handle& root,
+					   std::size_t, std::size_t, state&, Statistics& statistics)
+	{
+		using Rotator = SplayTreeRotator<T>;
+		while(node != S::null && storage.parent(node) != S::null
+			  && storage.parent(storage.parent(node)) != S::null)
+		{
+			auto parent = storage.parent(node);
+			if(utils::is_left_son_of_left_son(storage, node))
+			{ // Zig-zig, only the parent moves up.
+				statistics.zig_zig();
+				Rotator::rotate_right(storage, storage.parent(parent), root, statistics);
+				node = parent;
+			}
+			else if(utils::is_right_son_of_right_son(storage, node))
+			{
+				statistics.zig_zig();
+				Rotator::rotate_left(storage, storage.parent(parent), root, statistics);
+				node = parent;
+			}
+			else if(utils::is_left_son_of_right_son(storage, node))
+			{ // Zig-zag, same as when splaying.
+				statistics.zig_zag();
+				Rotator::rotate_right(storage, parent, root, statistics);
+				Rotator::rotate_left(storage, storage.parent(node), root, statistics);
+			}
+			else
+			{
+				statistics.zig_zag();
+				Rotator::rotate_left(storage, parent, root, statistics);
+				Rotator::rotate_right(storage, storage.parent(node), root, statistics);
+			}
+		}
+	}
+};
+
+/**
+ * Conditional splaying, a looked up node is splayed only if its depth
+ * exceeds Factor * log2(n), so lookups of nodes that are already near
+ * the root write nothing. Operations that change the tree always splay.
+ */
+template<typename T, std::size_t Factor = 2>
+struct DepthThresholdSplayPolicy
+{
+	/**
+	 * Splays bottom-up once the node has been found.
+	 */
+	static constexpr bool top_down{false};
+
+	/**
+	 * The policy keeps no state in the trees.
+	 */
+	struct state
+	{ /* DUMMY BODY */ };
+
+	/**
+	 * Propagates a given node to the top of the tree.
+	 */
+	template<typename N>
+	static void splay(N* node, N** root)
+	{
+		DoubleRotationSplayPolicy<T>::splay(node, root);
+	}
+
+	/**
+	 * Propagates a given node to the top of the tree and
+	 * records the steps in given statistics.
+	 */
+	template<typename N, typename Statistics>
+	static void splay(N* node, N** root, Statistics& statistics)
+	{
+		DoubleRotationSplayPolicy<T>::splay(node, root, statistics);
+	}
+
+	/**
+	 * Propagates a given node of a given storage to the top of
+	 * the tree and records the steps in given statistics.
+	 */
+	template<typename S, typename Statistics>
+	static void splay(S& storage, typename S::handle node,
+					  typename S::handle& root, Statistics& statistics)
+	{
+		DoubleRotationSplayPolicy<T>::splay(storage, node, root, statistics);
+	}
+
+	/**
+	 * Splays a given node after it has been looked up if it is too deep.
+	 * Param: The node.
+	 * Param: Root of the entire tree.
+	 * Param: Depth of the node.
+	 * Param: Number of nodes in the tree.
+	 * Param: State of the policy.
+	 * Param: Statistics the steps are recorded in.
+	 */
+	template<typename N, typename Statistics>
+	static void access(N* node, N** root, std::size_t depth, std::size_t size,
+					   state& policy_state, Statistics& statistics)
+	{
+		PointerNodeStorage<N> storage{};
+		access(storage, node, *root, depth, size, policy_state, statistics);
+	}
+
+	/**
+	 * Splays a given node of a given storage after it has
+	 * been looked up if it is too deep.
+	 */
+	template<typename S, typename Statistics>
+	static void access(S& storage, typename S::handle node, typename S::handle& root,
+					   std::size_t depth, std::size_t size, state&, Statistics& statistics)
+	{
+		if(depth > Factor * utils::floor_log2(size))
+			DoubleRotationSplayPolicy<T>::splay(storage, node, root, statistics);
+	}
+};
+
+/**
+ * Randomized splaying, a looked up node is splayed only with
+ * a given probability (in percents). Every tree draws from its own
+ * generator with a fixed seed, so runs are reproducible. Operations
+ * that change the tree always splay.
+ */
+template<typename T, unsigned Percent = 50, std::uint64_t Seed = 0x5EED>
+struct ProbabilisticSplayPolicy
+{
+	/**
+	 * Splays bottom-up once the node has been found.
+	 */
+	static constexpr bool top_down{false};
+
+	/**
+	 * State of the random generator (splitmix64) of a tree.
+	 */
+	struct state
+	{
+		std::uint64_t value{Seed};
+	};
+
+	/**
+	 * Propagates a given node to the top of the tree.
+	 */
+	template<typename N>
+	static void splay(N* node, N** root)
+	{
+		DoubleRotationSplayPolicy<T>::splay(node, root);
+	}
+
+	/**
+	 * Propagates a given node to the top of the tree and
+	 * records the steps in given statistics.
+	 */
+	template<typename N, typename Statistics>
+	static void splay(N* node, N** root, Statistics& statistics)
+	{
+		DoubleRotationSplayPolicy<T>::splay(node, root, statistics);
+	}
+
+	/**
+	 * Propagates a given node of a given storage to the top of
+	 * the tree and records the steps in given statistics.
+	 */
+	template<typename S, typename Statistics>
+	static void splay(S& storage, typename S::handle node,
+					  typename S::handle& root, Statistics& statistics)
+	{
+		DoubleRotationSplayPolicy<T>::splay(storage, node, root, statistics);
+	}
+
+	/**
+	 * Splays a given node after it has been looked up with
+	 * the probability of the policy.
+	 * Param: The node.
+	 * Param: Root of the entire tree.
+	 * Param: Depth of the node.
+	 * Param: Number of nodes in the tree.
+	 * Param: State of the policy.
+	 * Param: Statistics the steps are recorded in.
+	 */
+	template<typename N, typename Statistics>
+	static void access(N* node, N** root, std::size_t depth, std::size_t size,
+					   state& generator, Statistics& statistics)
+	{
+		PointerNodeStorage<N> storage{};
+		access(storage, node, *root, depth, size, generator, statistics);
+	}
+
+	/**
+	 * Splays a given node of a given storage after it has been
+	 * looked up with the probability of the policy.
+	 */
+	template<typename S, typename Statistics>
+	static void access(S& storage, typename S::handle node, typename S::handle& root,
+					   std::size_t, std::size_t, state& generator, Statistics& statistics)
+	{
+		auto random = generator.value += 0x9E3779B97F4A7C15u;
+		random = (random ^ (random >> 30)) * 0xBF58476D1CE4E5B9u;
+		random = (random ^ (random >> 27)) * 0x94D049BB133111EBu;
+		random ^= random >> 31;
+
+		if(random % 100 < Percent)
+			DoubleRotationSplayPolicy<T>::splay(storage, node, root, statistics);
+	}
+};
+
+/**
+ * Sequence (rope) of values of a given type kept in a splay tree, the
+ * order is given by the positions of the values instead of keys. The
+ * nodes keep the sizes of their subtrees, a position is found by
+ * descending by the sizes and the node is then splayed by the double
+ * rotation policy. Inserting, erasing, splitting and concatenating thus
+ * take O(log n) amortized without moving any values. Reversing a range
+ * and adding a value to every value in a range are lazy: the range is
+ * split off, tagged at its root and joined back, the tags are pushed
+ * down to the sons whenever a descent passes the node.
+ */
+template<typename T, template<typename> class Allocator = SlabAllocator>
+class SplaySequence
+{
+	public:
+		/**
+		 * Type of the nodes this sequence consists of.
+		 */
+		using node_type = SequenceNode<T>;
+
+		/**
+		 * Constructor.
+		 */
+		SplaySequence() = default;
+
+		/**
+		 * Constructor.
+		 * Param: Iterator to the first of the values.
+		 * Param: Iterator past the last of the values.
+		 */
+		template<typename Iterator>
+		SplaySequence(Iterator first, Iterator last)
+		{
+			assign(first, last);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~SplaySequence()
+		{
+			destroy_();
+		}
+
+		/**
+		 * The sequence owns its nodes.
+		 */
+		SplaySequence(const SplaySequence&) = delete;
+		SplaySequence& operator=(const SplaySequence&) = delete;
+
+		/**
+		 * Replaces the contents of the sequence with values from
+		 * a given range, a perfectly balanced tree is built in
+		 * linear time without any rotations.
+		 * Param: Iterator to the first of the values.
+		 * Param: Iterator past the last of the values.
+		 */
+		template<typename Iterator>
+		void assign(Iterator first, Iterator last)
+		{
+			clear();
+
+			auto count = static_cast<std::size_t>(std::distance(first, last));
+			allocator_.reserve(count);
+			root_ = build_(first, count);
+			utils::set_parent<node_type>(root_, nullptr);
+		}
+
+		/**
+		 * Removes all values from the sequence, the memory used
+		 * by the nodes is kept by the allocator for reuse.
+		 */
+		void clear()
+		{
+			destroy_();
+			if(allocator_.exclusive())
+				allocator_.reset();
+			root_ = nullptr;
+		}
+
+		/**
+		 * Returns the number of values.
+		 */
+		std::size_t size() const
+		{
+			return size_(root_);
+		}
+
+		/**
+		 * Returns true if the sequence contains no values.
+		 */
+		bool empty() const
+		{
+			return !root_;
+		}
+
+		/**
+		 * Returns the value at a given position, its node is splayed.
+		 * Throws std::out_of_range if the sequence is shorter.
+		 */
+		T& at(std::size_t position)
+		{
+			if(position >= size())
+				throw std::out_of_range{"Position in the sequence is out of range."};
+
+			auto node = select_(root_, position);
+			DoubleRotationSplayPolicy<T>::splay(node, &root_);
+
+			return node->value;
+		}
+
+		/**
+		 * Inserts a given value before a given position, so that
+		 * it ends up at that position.
+		 * Throws std::out_of_range if the position is past the end.
+		 */
+		void insert_at(std::size_t position, T value)
+		{
+			if(position > size())
+				throw std::out_of_range{"Position in the sequence is out of range."};
+
+			auto right = split_(root_, position);
+			auto node = allocator_.allocate(std::move(value));
+			node->left = root_;
+			node->right = right;
+			utils::set_parent(root_, node);
+			utils::set_parent(right, node);
+			utils::update(node);
+			root_ = node;
+		}
+
+		/**
+		 * Appends a given value.
+		 */
+		void push_back(T value)
+		{
+			insert_at(size(), std::move(value));
+		}
+
+		/**
+		 * Removes the values at positions [first, last).
+		 * Throws std::out_of_range if the range is not in the sequence.
+		 */
+		void erase_range(std::size_t first, std::size_t last)
+		{
+			auto middle = cut_(first, last);
+			destroy_(middle);
+		}
+
+		/**
+		 * Moves all values at a given position and behind it to a new
+		 * sequence which is returned. No nodes are copied, the two
+		 * sequences share the memory of the allocator.
+		 * Throws std::out_of_range if the position is past the end.
+		 */
+		SplaySequence split_at(std::size_t position)
+		{
+			if(position > size())
+				throw std::out_of_range{"Position in the sequence is out of range."};
+
+			auto right = split_(root_, position);
+			return SplaySequence{right, allocator_};
+		}
+
+		/**
+		 * Appends all values of a given sequence, which ends up empty.
+		 */
+		void concat(SplaySequence& other)
+		{
+			if(&other == this)
+				return;
+
+			allocator_.adopt(other.allocator_);
+			root_ = join_(root_, other.root_);
+			other.root_ = nullptr;
+		}
+
+		/**
+		 * Reverses the order of the values at positions [first, last)
+		 * lazily. Throws std::out_of_range if the range is not in the
+		 * sequence.
+		 */
+		void reverse(std::size_t first, std::size_t last)
+		{
+			auto middle = cut_(first, last);
+			if(middle)
+				middle->reversed = !middle->reversed;
+			paste_(first, middle);
+		}
+
+		/**
+		 * Adds a given value to the values at positions [first, last)
+		 * lazily. Throws std::out_of_range if the range is not in the
+		 * sequence.
+		 */
+		void add(std::size_t first, std::size_t last, const T& value)
+		{
+			static_assert(utils::is_addable<T>::value, "Values have to support +=.");
+
+			auto middle = cut_(first, last);
+			if(middle)
+				add_(middle, value);
+			paste_(first, middle);
+		}
+
+		/**
+		 * Calls a given function with every value in order, the
+		 * tags are pushed down on the way, but nothing is splayed.
+		 */
+		template<typename Function>
+		void for_each(Function&& function)
+		{
+			std::vector<node_type*> stack{};
+			auto node = root_;
+			while(node || !stack.empty())
+			{
+				for(; node; node = node->left)
+				{
+					push_down_(node);
+					stack.push_back(node);
+				}
+
+				node = stack.back();
+				stack.pop_back();
+				function(static_cast<const T&>(node->value));
+				node = node->right;
+			}
+		}
+
+		/**
+		 * Returns true if the sizes and the parent
+		 * pointers of all nodes are consistent.
+		 */
+		bool validate() const
+		{
+			if(root_ && root_->parent)
+				return false;
+
+			std::vector<node_type*> stack{};
+			if(root_)
+				stack.push_back(root_);
+			while(!stack.empty())
+			{
+				auto node = stack.back();
+				stack.pop_back();
+				if(node->size != 1 + size_(node->left) + size_(node->right))
+					return false;
+
+				for(auto son : {node->left, node->right})
+				{
+					if(!son)
+						continue;
+					if(son->parent != node)
+						return false;
+					stack.push_back(son);
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		/**
+		 * Constructor used by split_at, the new sequence
+		 * shares the memory of a given allocator.
+		 */
+		SplaySequence(node_type* root, const Allocator<node_type>& allocator)
+			: root_{root}, allocator_{allocator}
+		{ /* DUMMY BODY */ }
+
+		/**
+		 * Returns the number of nodes in a given subtree.
+		 */
+		static std::size_t size_(const node_type* node)
+		{
+			return node ? node->size : std::size_t{};
+		}
+
+		/**
+		 * Adds a given value to all values in the subtree
+		 * of a given node.
+		 */
+		static void add_(node_type* node, const T& value)
+		{
+			node->value += value;
+			node->added += value;
+			node->adding = true;
+		}
+
+		/**
+		 * Applies the tags of a given node to its sons.
+		 */
+		static void push_down_(node_type* node)
+		{
+			if(node->reversed)
+			{
+				std::swap(node->left, node->right);
+				if(node->left)
+					node->left->reversed = !node->left->reversed;
+				if(node->right)
+					node->right->reversed = !node->right->reversed;
+				node->reversed = false;
+			}
+
+			if constexpr(utils::is_addable<T>::value)
+			{
+				if(node->adding)
+				{
+					if(node->left)
+						add_(node->left, node->added);
+					if(node->right)
+						add_(node->right, node->added);
+					node->added = T{};
+					node->adding = false;
+				}
+			}
+		}
+
+		/**
+		 * Returns the node at a given position of a given subtree,
+		 * the tags of all nodes on the path are pushed down, so the
+		 * node can be splayed.
+		 */
+		static node_type* select_(node_type* node, std::size_t position)
+		{
+			while(true)
+			{
+				push_down_(node);
+				auto left_size = size_(node->left);
+				if(position == left_size)
+					return node;
+				else if(position < left_size)
+					node = node->left;
+				else
+				{
+					position -= left_size + 1;
+					node = node->right;
+				}
+			}
+		}
+
+		/**
+		 * Detaches the values at a given position and behind it
+		 * from a given subtree and returns the root of the
+		 * detached subtree.
+		 */
+		static node_type* split_(node_type*& root, std::size_t position)
+		{
+			if(position >= size_(root))
+				return nullptr;
+
+			auto node = select_(root, position);
+			DoubleRotationSplayPolicy<T>::splay(node, &root);
+
+			root = node->left;
+			node->left = nullptr;
+			utils::set_parent<node_type>(root, nullptr);
+			utils::update(node);
+
+			return node;
+		}
+
+		/**
+		 * Joins two subtrees, the values of the second one
+		 * follow those of the first one.
+		 * Returns the root of the joined tree.
+		 */
+		static node_type* join_(node_type* left, node_type* right)
+		{
+			if(!left)
+				return right;
+
+			auto max = select_(left, left->size - 1);
+			DoubleRotationSplayPolicy<T>::splay(max, &left);
+			left->right = right;
+			utils::set_parent(right, left);
+			utils::update(left);
+
+			return left;
+		}
+
+		/**
+		 * Detaches the values at positions [first, last) and
+		 * returns the root of their subtree, the rest of the
+		 * sequence is joined back together.
+		 */
+		node_type* cut_(std::size_t first, std::size_t last)
+		{
+			if(first > last || last > size())
+				throw std::out_of_range{"Range of the sequence is out of range."};
+
+			auto right = split_(root_, last);
+			auto middle = split_(root_, first);
+			root_ = join_(root_, right);
+
+			return middle;
+		}
+
+		/**
+		 * Inserts a subtree detached by cut_ back
+		 * at a given position.
+		 */
+		void paste_(std::size_t position, node_type* middle)
+		{
+			auto right = split_(root_, position);
+			root_ = join_(join_(root_, middle), right);
+		}
+
+		/**
+		 * Builds a balanced subtree from a given number of values,
+		 * the iterator ends up past the last value of the subtree.
+		 * Returns the root of the subtree.
+		 */
+		template<typename Iterator>
+		node_type* build_(Iterator& it, std::size_t count)
+		{
+			if(count == 0)
+				return nullptr;
+
+			auto left = build_(it, count / 2);
+			auto node = allocator_.allocate(*it);
+			++it;
+			auto right = build_(it, count - count / 2 - 1);
+
+			node->left = left;
+			node->right = right;
+			utils::set_parent(left, node);
+			utils::set_parent(right, node);
+			utils::update(node);
+
+			return node;
+		}
+
+		/**
+		 * Destroys all nodes of the sequence, arenas free all
+		 * nodes at once, so the tree only has to be walked
+		 * if the values need to be destroyed or if other
+		 * sequences share the arena (and can reuse the nodes).
+		 */
+		void destroy_()
+		{
+			constexpr bool walk = !Allocator<node_type>::releases_in_bulk
+				|| !std::is_trivially_destructible<node_type>::value;
+
+			if(walk || !allocator_.exclusive())
+				destroy_(root_);
+		}
+
+		/**
+		 * Returns all nodes of a given subtree to the allocator, the
+		 * subtree is walked iteratively, as sequences built by appending
+		 * are too deep for recursion.
+		 */
+		void destroy_(node_type* node)
+		{
+			std::vector<node_type*> stack{};
+			if(node)
+				stack.push_back(node);
+
+			while(!stack.empty())
+			{
+				node = stack.back();
+				stack.pop_back();
+				if(node->left)
+					stack.push_back(node->left);
+				if(node->right)
+					stack.push_back(node->right);
+				allocator_.deallocate(node);
+			}
+		}
+
+		/**
+		 * Root node of the splay tree.
+		 */
+		node_type* root_{};
+
+		/**
+		 * Allocator that creates the nodes.
+		 */
+		Allocator<node_type> allocator_{};
+};
+
+/**
+ * Link-cut tree of Sleator and Tarjan, represents a forest of rooted
+ * trees whose vertices keep values and supports linking and cutting
+ * trees along with path queries in O(log n) amortized time. Every tree
+ * is decomposed into preferred paths, each of which is kept in a splay
+ * tree ordered from the top of the path to its bottom. The splay trees
+ * use the double rotation policy and SplayTreeRotator unchanged: the
+ * parent pointer of a node is null exactly at the root of its path (the
+ * path root check), the parent of the topmost vertex of the path is kept
+ * in path_parent of that root and moved to the new root after a splay.
+ * The rotator updates the path aggregates (see utils::update).
+ */
+template<typename T = int, typename Aggregate = SumAggregate<T>,
+		 template<typename> class Allocator = SlabAllocator>
+class LinkCutTree
+{
+	public:
+		/**
+		 * Type of the nodes this tree consists of.
+		 */
+		using node_type = LinkCutNode<T, Aggregate>;
+
+		/**
+		 * Handle of a vertex of the forest.
+		 */
+		using vertex = node_type*;
+
+		/**
+		 * Type of the aggregates of paths.
+		 */
+		using aggregate_type = typename Aggregate::value_type;
+
+		/**
+		 * Constructor.
+		 */
+		LinkCutTree() = default;
+
+		/**
+		 * Destructor.
+		 */
+		~LinkCutTree()
+		{
+			constexpr bool walk = !Allocator<node_type>::releases_in_bulk
+				|| !std::is_trivially_destructible<node_type>::value;
+
+			if(walk)
+			{
+				for(auto node : vertices_)
+					allocator_.deallocate(node);
+			}
+		}
+
+		/**
+		 * The tree owns its nodes.
+		 */
+		LinkCutTree(const LinkCutTree&) = delete;
+		LinkCutTree& operator=(const LinkCutTree&) = delete;
+
+		/**
+		 * Adds a new vertex with a given value, which
+		 * forms a tree of its own.
+		 */
+		vertex add_vertex(T value)
+		{
+			auto node = allocator_.allocate(std::move(value));
+			vertices_.push_back(node);
+
+			return node;
+		}
+
+		/**
+		 * Returns the number of vertices in the forest.
+		 */
+		std::size_t vertex_count() const
+		{
+			return vertices_.size();
+		}
+
+		/**
+		 * Returns the value of a given vertex.
+		 */
+		const T& value(vertex node) const
+		{
+			return node->key;
+		}
+
+		/**
+		 * Changes the value of a given vertex.
+		 */
+		void set_value(vertex node, T value)
+		{
+			access_(node);
+			node->key = std::move(value);
+			utils::update(node);
+		}
+
+		/**
+		 * Makes a given vertex the child of another vertex, the
+		 * tree of the child is rerooted at the child first.
+		 * Returns false if the vertices are already connected.
+		 */
+		bool link(vertex child, vertex parent)
+		{
+			if(connected(child, parent))
+				return false;
+
+			make_root(child);
+			child->path_parent = parent;
+
+			return true;
+		}
+
+		/**
+		 * Removes the edge between a given vertex and its parent.
+		 * Returns false if the vertex is a root.
+		 */
+		bool cut(vertex node)
+		{
+			access_(node);
+			if(!node->left)
+				return false;
+
+			node->left->parent = nullptr;
+			node->left = nullptr;
+			utils::update(node);
+
+			return true;
+		}
+
+		/**
+		 * Removes the edge between two given vertices, the roots
+		 * of the trees do not change.
+		 * Returns false if there is no such edge.
+		 */
+		bool cut(vertex first, vertex second)
+		{
+			if(parent(first) == second)
+				return cut(first);
+			else if(parent(second) == first)
+				return cut(second);
+			else
+				return false;
+		}
+
+		/**
+		 * Returns the parent of a given vertex or
+		 * nullptr if the vertex is a root.
+		 */
+		vertex parent(vertex node)
+		{
+			access_(node);
+			if(!node->left)
+				return nullptr;
+
+			auto parent = node->left;
+			for(push_down_(parent); parent->right; push_down_(parent))
+				parent = parent->right;
+			splay_(parent);
+
+			return parent;
+		}
+
+		/**
+		 * Returns the root of the tree containing a given vertex.
+		 */
+		vertex find_root(vertex node)
+		{
+			access_(node);
+
+			auto root = node;
+			for(push_down_(root); root->left; push_down_(root))
+				root = root->left;
+			splay_(root);
+
+			return root;
+		}
+
+		/**
+		 * Returns true if two given vertices are in the same tree.
+		 */
+		bool connected(vertex first, vertex second)
+		{
+			return first == second || find_root(first) == find_root(second);
+		}
+
+		/**
+		 * Returns the lowest common ancestor of two given
+		 * vertices or nullptr if they are not connected.
+		 */
+		vertex lca(vertex first, vertex second)
+		{
+			if(!connected(first, second))
+				return nullptr;
+
+			access_(first);
+			return access_(second);
+		}
+
+		/**
+		 * Makes a given vertex the root of its tree.
+		 */
+		void make_root(vertex node)
+		{
+			access_(node);
+			reverse_(node);
+		}
+
+		/**
+		 * Returns the aggregate of the values on the path between two
+		 * given vertices, combined from the first to the second one.
+		 * The roots of the trees do not change.
+		 * Throws std::invalid_argument if the vertices are not connected.
+		 */
+		aggregate_type path_aggregate(vertex first, vertex second)
+		{
+			auto root = find_root(first);
+			if(root != find_root(second))
+				throw std::invalid_argument{"Vertices of the path are not connected."};
+
+			make_root(first);
+			access_(second);
+			auto result = second->aggregate;
+			make_root(root);
+
+			return result;
+		}
+
+	private:
+		/**
+		 * Reverses the path in the subtree of a given node lazily.
+		 */
+		static void reverse_(node_type* node)
+		{
+			node->reversed = !node->reversed;
+			std::swap(node->aggregate, node->reverse_aggregate);
+		}
+
+		/**
+		 * Applies the reversal tag of a given node to its sons.
+		 */
+		static void push_down_(node_type* node)
+		{
+			if(node->reversed)
+			{
+				std::swap(node->left, node->right);
+				if(node->left)
+					reverse_(node->left);
+				if(node->right)
+					reverse_(node->right);
+				node->reversed = false;
+			}
+		}
+
+		/**
+		 * Propagates a given node to the root of the splay tree of
+		 * its path. The tags are pushed down from that root first, so
+		 * the rotated nodes have their sons in the final order.
+		 */
+		void splay_(node_type* node)
+		{
+			path_.clear();
+			auto root = node;
+			path_.push_back(root);
+			while(root->parent)
+			{
+				root = root->parent;
+				path_.push_back(root);
+			}
+			for(auto it = path_.rbegin(); it != path_.rend(); ++it)
+				push_down_(*it);
+
+			auto path_parent = root->path_parent;
+			root->path_parent = nullptr;
+			DoubleRotationSplayPolicy<T>::splay(node, &root);
+			node->path_parent = path_parent;
+		}
+
+		/**
+		 * Makes the path from the root of the tree to a given node
+		 * preferred, the node ends up at the root of its splay tree
+		 * with no right son.
+		 * Returns the last vertex at which the path joined the
+		 * preferred path of the root.
+		 */
+		node_type* access_(node_type* node)
+		{
+			splay_(node);
+			detach_right_(node);
+
+			auto last = node;
+			while(node->path_parent)
+			{
+				last = node->path_parent;
+				splay_(last);
+				detach_right_(last);
+
+				last->right = node;
+				node->parent = last;
+				node->path_parent = nullptr;
+				utils::update(last);
+				splay_(node);
+			}
+
+			return last;
+		}
+
+		/**
+		 * Makes the right son of a given splay tree root
+		 * the root of a path of its own.
+		 */
+		static void detach_right_(node_type* node)
+		{
+			if(!node->right)
+				return;
+
+			node->right->path_parent = node;
+			node->right->parent = nullptr;
+			node->right = nullptr;
+			utils::update(node);
+		}
+
+		/**
+		 * Vertices of the forest.
+		 */
+		std::vector<node_type*> vertices_{};
+
+		/**
+		 * Nodes on the path to the root of a splay tree,
+		 * kept to avoid allocations in splay_.
+		 */
+		std::vector<node_type*> path_{};
+
+		/**
+		 * Allocator that creates the nodes.
+		 */
+		Allocator<node_type> allocator_{};
+};
+
+/**
+ * Description of the binary instruction file format, the file
+ * starts with a header:
+ *   4 bytes  magic "SPLB"
+ *   1 byte   version
+ *   3 bytes  reserved (zero)
+ *   8 bytes  number of batches (little endian)
+ * followed by records, each consisting of a single opcode byte
+ * ('#', 'I' or 'F', same as the tokens of the text format) and its
+ * operand (batch size or key) encoded as a zigzag LEB128 varint.
+ */
+namespace binary_trace
+{
+	/**
+	 * Magic bytes identifying binary files.
+	 */
+	constexpr char magic[4]{'S', 'P', 'L', 'B'};
+
+	/**
+	 * Current version of the format.
+	 */
+	constexpr unsigned char version{1};
+
+	/**
+	 * Size of the header in bytes.
+	 */
+	constexpr std::size_t header_size{16};
+
+	/**
+	 * Maps signed integers to unsigned ones so that numbers
+	 * with small absolute values have short encodings.
+	 */
+	inline std::uint64_t zigzag(std::int64_t value)
+	{
+		return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+	}
+
+	/**
+	 * Inverse of zigzag.
+	 */
+	inline std::int64_t unzigzag(std::uint64_t value)
+	{
+		return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+	}
+}
+
+/**
+ * Reader of the instruction files that maps the whole file into
+ * memory and scans it in place, tokens are returned as views into
+ * the mapping and numbers are decoded by hand, so nothing is allocated
+ * per token. Mimics the behaviour of an input stream: once a read
+ * fails, all subsequent reads fail as well and leave their output
+ * unchanged. Both the text and the binary (see binary_trace) format
+ * are supported, the format is detected from the header.
+ */
+class TraceParser
+{
+	public:
+		/**
+		 * Constructor.
+		 * Param: Name of the input file.
+		 */
+		TraceParser(const std::string& file_name)
+		{
+			auto fd = ::open(file_name.c_str(), O_RDONLY);
+			if(fd < 0)
+			{
+				DEBUG("Cannot open file: " + file_name + ".");
+				failed_ = true;
+				return;
+			}
+
+			struct stat info{};
+			if(::fstat(fd, &info) == 0 && info.st_size > 0)
+			{
+				size_ = static_cast<std::size_t>(info.st_size);
+				auto data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(data != MAP_FAILED)
+				{
+					::madvise(data, size_, MADV_SEQUENTIAL);
+					data_ = static_cast<const char*>(data);
+					pos_ = data_;
+					end_ = data_ + size_;
+					read_header_();
+				}
+				else
+				{
+					DEBUG("Cannot map file: " + file_name + ".");
+					size_ = std::size_t{};
+					failed_ = true;
+				}
+			}
+			::close(fd);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~TraceParser()
+		{
+			close();
+		}
+
+		/**
+		 * The parser owns the mapping.
+		 */
+		TraceParser(const TraceParser&) = delete;
+		TraceParser& operator=(const TraceParser&) = delete;
+
+		/**
+		 * Unmaps the file.
+		 */
+		void close()
+		{
+			if(data_)
+				::munmap(const_cast<char*>(data_), size_);
+			data_ = pos_ = end_ = nullptr;
+			size_ = std::size_t{};
+		}
+
+		/**
+		 * Reads the next whitespace delimited token.
+		 * Returns false (and leaves the token unchanged) on failure.
+		 */
+		bool next_token(std::string_view& token)
+		{
+			if(binary_ && !failed_ && pos_ != end_)
+			{ // Opcodes are single bytes.
+				token = std::string_view{pos_++, 1};
+				return true;
+			}
+
+			if(failed_ || binary_ || !skip_whitespace_())
+				return fail_();
+
+			auto begin = pos_;
+			while(pos_ != end_ && !is_whitespace_(*pos_))
+				++pos_;
+			token = std::string_view{begin, static_cast<std::size_t>(pos_ - begin)};
+
+			return true;
+		}
+
+		/**
+		 * Reads the next integer, like formatted input, the number
+		 * ends at the first character that is not a digit.
+		 * Returns false on failure, the number is then set like by
+		 * operator>>: to the closest representable value if it does
+		 * not fit, to zero if there are no digits and left unchanged
+		 * at the end of the file. Unlike operator>>, negative numbers
+		 * are rejected for unsigned types (the stream wraps them).
+		 */
+		template<typename T>
+		bool next_number(T& number)
+		{
+			static_assert(std::is_integral<T>::value, "Only integers can be parsed.");
+
+			if(binary_)
+				return next_varint_(number);
+
+			if(failed_ || !skip_whitespace_())
+				return fail_();
+
+			bool negative{false};
+			if(*pos_ == '-' || *pos_ == '+')
+			{
+				negative = *pos_ == '-';
+				++pos_;
+			}
+
+			using U = std::make_unsigned_t<T>;
+			U limit = negative ? U(U(std::numeric_limits<T>::max()) + U(std::is_signed<T>::value))
+							   : U(std::numeric_limits<T>::max());
+			U value{};
+			bool overflow{false};
+			auto begin = pos_;
+			while(pos_ != end_ && *pos_ >= '0' && *pos_ <= '9')
+			{ // All digits are consumed even when the number does not fit.
+				U digit = static_cast<U>(*pos_ - '0');
+				if(overflow || value > (limit - digit) / 10)
+					overflow = true;
+				else
+					value = value * 10 + digit;
+				++pos_;
+			}
+
+			if(overflow && pos_ != begin && (!negative || std::is_signed<T>::value))
+			{
+				number = negative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+				return fail_();
+			}
+			if(pos_ == begin || (negative && !std::is_signed<T>::value))
+			{
+				number = T{};
+				return fail_();
+			}
+
+			number = negative ? static_cast<T>(U{} - value) : static_cast<T>(value);
+			return true;
+		}
+
+		/**
+		 * Reads the next key, integers are read by next_number, keys
+		 * of other types (e.g. std::string) are constructed from the
+		 * next token, which only the text format supports.
+		 * Returns false (and leaves the key unchanged) on failure.
+		 */
+		template<typename T>
+		bool next_key(T& key)
+		{
+			if constexpr(std::is_integral<T>::value)
+				return next_number(key);
+			else
+			{
+				if(binary_)
+				{
+					DEBUG("Only integer keys can be stored in binary files.");
+					return fail_();
+				}
+
+				std::string_view token{};
+				if(!next_token(token))
+					return false;
+
+				key = T{token};
+				return true;
+			}
+		}
+
+		/**
+		 * Returns true if no read has failed so far.
+		 */
+		bool good() const
+		{
+			return !failed_;
+		}
+
+		/**
+		 * Returns true if the file is in the binary format.
+		 */
+		bool binary() const
+		{
+			return binary_;
+		}
+
+		/**
+		 * Returns the number of batches stored in the header
+		 * of a binary file.
+		 */
+		std::uint64_t batch_count() const
+		{
+			return batch_count_;
+		}
+
+		/**
+		 * Returns the current position in the file.
+		 */
+		std::size_t offset() const
+		{
+			return static_cast<std::size_t>(pos_ - data_);
+		}
+
+		/**
+		 * Moves to a given position in the file.
+		 */
+		void seek(std::size_t offset)
+		{
+			if(data_)
+				pos_ = data_ + std::min(offset, size_);
+		}
+
+		/**
+		 * Pre-scans the file for batch headers without reading it. Returns
+		 * the offset of the first instruction followed by the offsets of
+		 * headers that are at least a given distance from the previous
+		 * returned offset. These are only candidates, whether a batch
+		 * really starts at them depends on the instructions before.
+		 */
+		std::vector<std::size_t> batch_offsets(std::size_t distance) const
+		{
+			std::size_t begin = binary_ ? binary_trace::header_size : std::size_t{};
+			std::vector<std::size_t> offsets{begin};
+			if(failed_ || !data_)
+				return offsets;
+
+			distance = std::max(distance, std::size_t{1});
+			if(binary_)
+			{ // Records have to be skipped one by one, varint bytes can look like opcodes.
+				for(auto pos = data_ + begin; pos < end_; )
+				{
+					auto offset = static_cast<std::size_t>(pos - data_);
+					bool header = *pos++ == '#';
+					while(pos < end_ && (static_cast<unsigned char>(*pos) & 0x80u))
+						++pos;
+					++pos;
+
+					if(header && offset >= offsets.back() + distance)
+						offsets.push_back(offset);
+				}
+			}
+			else
+			{
+				for(auto pos = begin + distance; pos < size_; )
+				{
+					auto header = static_cast<const char*>(std::memchr(data_ + pos, '#', size_ - pos));
+					if(!header)
+						break;
+
+					auto offset = static_cast<std::size_t>(header - data_);
+					if((offset == 0 || is_whitespace_(data_[offset - 1]))
+					   && (offset + 1 == size_ || is_whitespace_(data_[offset + 1])))
+					{
+						offsets.push_back(offset);
+						pos = offset + distance;
+					}
+					else
+						pos = offset + 1;
+				}
+			}
+
+			return offsets;
+		}
+
+		/**
+		 * Returns the size of the file.
+		 */
+		std::size_t size() const
+		{
+			return size_;
+		}
+
+	private:
+		/**
+		 * Checks if the file starts with the binary header and
+		 * if so, reads it.
+		 */
+		void read_header_()
+		{
+			using namespace binary_trace;
+			if(size_ < sizeof(magic) || std::memcmp(data_, magic, sizeof(magic)) != 0)
+				return;
+
+			binary_ = true;
+			if(size_ < header_size || static_cast<unsigned char>(data_[4]) != version)
+			{
+				DEBUG("Unsupported binary file.");
+				fail_();
+				return;
+			}
+
+			for(std::size_t i = 0; i < 8; ++i)
+				batch_count_ |= std::uint64_t{static_cast<unsigned char>(data_[8 + i])} << (8 * i);
+			pos_ = data_ + header_size;
+		}
+
+		/**
+		 * Reads the next number of a binary file.
+		 */
+		template<typename T>
+		bool next_varint_(T& number)
+		{
+			if(failed_)
+				return false;
+
+			std::uint64_t value{};
+			for(unsigned shift = 0; ; shift += 7)
+			{
+				if(pos_ == end_ || shift > 63)
+				{
+					number = T{};
+					return fail_();
+				}
+
+				auto byte = static_cast<unsigned char>(*pos_++);
+				value |= std::uint64_t{byte & 0x7Fu} << shift;
+				if(!(byte & 0x80u))
+					break;
+			}
+
+			auto decoded = binary_trace::unzigzag(value);
+			if(decoded < static_cast<std::int64_t>(std::numeric_limits<T>::min())
+			   || (decoded > 0 && static_cast<std::uint64_t>(decoded) > std::uint64_t{std::numeric_limits<T>::max()}))
+			{
+				number = T{};
+				return fail_();
+			}
+
+			number = static_cast<T>(decoded);
+			return true;
+		}
+
+		/**
+		 * Returns true for the characters that separate tokens.
+		 */
+		static bool is_whitespace_(char c)
+		{
+			return c == ' ' || c == '\n' || c == '\t'
+				|| c == '\r' || c == '\v' || c == '\f';
+		}
+
+		/**
+		 * Skips whitespace, returns false if the end of the
+		 * file has been reached.
+		 */
+		bool skip_whitespace_()
+		{
+			while(pos_ != end_ && is_whitespace_(*pos_))
+				++pos_;
+
+			return pos_ != end_;
+		}
+
+		/**
+		 * Marks the parser as failed, returns false for convenience.
+		 */
+		bool fail_()
+		{
+			failed_ = true;
+			return false;
+		}
+
+		/**
+		 * Mapped contents of the file.
+		 */
+		const char* data_{};
+
+		/**
+		 * Current position in the file.
+		 */
+		const char* pos_{};
+
+		/**
+		 * End of the file.
+		 */
+		const char* end_{};
+
+		/**
+		 * Size of the mapping.
+		 */
+		std::size_t size_{};
+
+		/**
+		 * True once a read has failed.
+		 */
+		bool failed_{};
+
+		/**
+		 * True if the file is in the binary format.
+		 */
+		bool binary_{};
+
+		/**
+		 * Number of batches of a binary file.
+		 */
+		std::uint64_t batch_count_{};
+};
+
+/**
+ * Converts instruction files between the text
+ * and the binary format.
+ */
+struct TraceConverter
+{
+	/**
+	 * Converts a text file to the binary format.
+	 * Returns false (and removes the output file) if the input
+	 * cannot be read or is not a valid instruction file. A file
+	 * that is already binary is refused, no output is written.
+	 * Param: Name of the text input file.
+	 * Param: Name of the binary output file.
+	 */
+	static bool to_binary(const std::string& in_file_name, const std::string& out_file_name)
+	{
+		TraceParser input{in_file_name};
+		if(input.binary())
+		{
+			DEBUG("Already a binary file: " + in_file_name + ".");
+			return false;
+		}
+		if(!input.good())
+		{
+			DEBUG("Cannot read file: " + in_file_name + ".");
+			return false;
+		}
+
+		std::ofstream output{out_file_name, std::ios::binary};
+
+		std::string header(binary_trace::header_size, '\0');
+		header.replace(0, sizeof(binary_trace::magic), binary_trace::magic, sizeof(binary_trace::magic));
+		header[4] = static_cast<char>(binary_trace::version);
+		output.write(header.data(), header.size());
+
+		std::string buffer{};
+		std::uint64_t batch_count{};
+		std::string_view token{};
+		std::int64_t number{};
+		while(input.next_token(token))
+		{
+			if(token != "#" && token != "I" && token != "F")
+			{
+				DEBUG("Invalid token: " + std::string{token} + ".");
+				return discard_(output, out_file_name);
+			}
+			if(!input.next_number(number))
+			{
+				DEBUG("Missing number after: " + std::string{token} + ".");
+				return discard_(output, out_file_name);
+			}
+
+			if(token == "#")
+				++batch_count;
+			buffer.push_back(token[0]);
+			write_varint_(buffer, binary_trace::zigzag(number));
+
+			if(buffer.size() >= buffer_size_)
+			{
+				output.write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+		}
+		output.write(buffer.data(), buffer.size());
+
+		// Patch the number of batches into the header.
+		for(std::size_t i = 0; i < 8; ++i)
+			header[8 + i] = static_cast<char>(batch_count >> (8 * i));
+		output.seekp(0);
+		output.write(header.data(), header.size());
+
+		return output ? true : discard_(output, out_file_name);
+	}
+
+	/**
+	 * Converts a binary file to the text format.
+	 * Returns false (and removes the output file) if the input
+	 * is not a valid binary file.
+	 * Param: Name of the binary input file.
+	 * Param: Name of the text output file.
+	 */
+	static bool to_text(const std::string& in_file_name, const std::string& out_file_name)
+	{
+		TraceParser input{in_file_name};
+		if(!input.binary() || !input.good())
+		{
+			DEBUG("Not a binary file: " + in_file_name + ".");
+			return false;
+		}
+
+		std::ofstream output{out_file_name};
+		std::string buffer{};
+		std::string_view token{};
+		std::int64_t number{};
+		while(input.next_token(token))
+		{
+			if(!input.next_number(number))
+			{
+				DEBUG("Truncated binary file: " + in_file_name + ".");
+				return discard_(output, out_file_name);
+			}
+
+			buffer.append(token);
+			buffer.push_back(' ');
+			buffer.append(std::to_string(number));
+			buffer.push_back('\n');
+
+			if(buffer.size() >= buffer_size_)
+			{
+				output.write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+		}
+		output.write(buffer.data(), buffer.size());
+
+		return output ? true : discard_(output, out_file_name);
+	}
+
+	private:
+		/**
+		 * Size of the output buffer after which it is flushed.
+		 */
+		static constexpr std::size_t buffer_size_{std::size_t{1} << 16};
+
+		/**
+		 * Closes and removes a partially written output file,
+		 * returns false for convenience.
+		 */
+		static bool discard_(std::ofstream& output, const std::string& file_name)
+		{
+			output.close();
+			std::remove(file_name.c_str());
+			return false;
+		}
+
+		/**
+		 * Appends a LEB128 varint to a given buffer.
+		 */
+		static void write_varint_(std::string& buffer, std::uint64_t value)
+		{
+			while(value >= 0x80u)
+			{
+				buffer.push_back(static_cast<char>((value & 0x7Fu) | 0x80u));
+				value >>= 7;
+			}
+			buffer.push_back(static_cast<char>(value));
+		}
+};
+
+/**
+ * Instructions of a single batch of an instruction file.
+ */
+template<typename T>
+struct TraceBatch
+{
+	/**
+	 * Number of instructions the batch header announced.
+	 */
+	std::size_t count{};
+
+	/**
+	 * Keys of the inserts in the order they were read.
+	 */
+	std::vector<T> inserts{};
+
+	/**
+	 * Keys of the finds in the order they were read.
+	 */
+	std::vector<T> finds{};
+};
+
+/**
+ * Reads an instruction file batch by batch. Malformed input
+ * is read exactly like it always was, so that the results
+ * do not depend on whether the batches are executed as they
+ * are read or later from memory.
+ */
+template<typename T>
+class TraceReader
+{
+	public:
+		/**
+		 * Constructor.
+		 * Param: Name of the input file.
+		 */
+		TraceReader(const std::string& file_name)
+			: input_{file_name}
+		{ /* DUMMY BODY */ }
+
+		/**
+		 * Reads the next batch into a given batch (whose buffers
+		 * get reused), returns false if there is none.
+		 */
+		bool next(TraceBatch<T>& batch)
+		{
+			if(!started_)
+			{
+				started_ = true;
+				input_.next_token(token_);
+				if(token_ != "#")
+				{
+					DEBUG("Invalid token #1: " + std::string{token_} + ".");
+					return false;
+				}
+			}
+
+			if(!input_.next_number(batch.count))
+				return false;
+
+			DEBUG("Starting a new batch of " + std::to_string(batch.count)
+				  + " instructions.");
+
+			batch.inserts.clear();
+			batch.finds.clear();
+			T key{};
+			for(std::size_t i = 0; i < batch.count; ++i)
+			{
+				input_.next_token(token_);
+				if(token_ == "I")
+				{
+					input_.next_key(key);
+					batch.inserts.push_back(key);
+				}
+				else
+				{
+					DEBUG("Only " + std::to_string(i + 1)
+						  + "inserts, expected " + std::to_string(batch.count) + ".");
+					break;
+				}
+			}
+
+			while(input_.next_token(token_) && token_ == "F")
+			{
+				input_.next_key(key);
+				batch.finds.push_back(key);
+			}
+
+			return true;
+		}
+
+		/**
+		 * Moves to a given position in the file, the next batch
+		 * is read as if the file started there.
+		 */
+		void seek(std::size_t offset)
+		{
+			input_.seek(offset);
+			started_ = false;
+		}
+
+		/**
+		 * Returns true if the last read token is the header of the batch
+		 * at a given offset, i.e. the next batch is read from there.
+		 */
+		bool at_header(std::size_t offset) const
+		{
+			return input_.good() && token_ == "#" && input_.offset() == offset + 1;
+		}
+
+		/**
+		 * Returns the offsets of candidate batch headers (see
+		 * TraceParser::batch_offsets).
+		 */
+		std::vector<std::size_t> batch_offsets(std::size_t distance) const
+		{
+			return input_.batch_offsets(distance);
+		}
+
+		/**
+		 * Returns the size of the file.
+		 */
+		std::size_t size() const
+		{
+			return input_.size();
+		}
+
+		/**
+		 * Reads all (remaining) batches of the file into memory.
+		 */
+		std::vector<TraceBatch<T>> read_all()
+		{
+			std::vector<TraceBatch<T>> batches{};
+			TraceBatch<T> batch{};
+			while(next(batch))
+				batches.push_back(std::move(batch));
+
+			return batches;
+		}
+
+	private:
+		/**
+		 * Parser of the input file.
+		 */
+		TraceParser input_;
+
+		/**
+		 * Last read token, it is kept between batches as
+		 * a failed read leaves it unchanged.
+		 */
+		std::string_view token_{};
+
+		/**
+		 * True once the first token has been read.
+		 */
+		bool started_{};
+};
+
+/**
+ * Options that change the way a task is executed.
+ */
+struct TaskOptions
+{
+	/**
+	 * If true, the longest strictly increasing prefix of the inserts
+	 * of every batch is bulk-loaded into a balanced tree instead of
+	 * being inserted key by key. This is much faster, but as the tree
+	 * starts balanced, the measured find lengths differ.
+	 */
+	bool bulk_load{false};
+
+	/**
+	 * If true, the finds of every batch are looked up together in
+	 * increasing order of their keys (see SplayTree::find_many). The
+	 * average find length is still computed per find, but the order
+	 * of the finds, and thus the measured lengths, differ.
+	 */
+	bool reorder_finds{false};
+
+	/**
+	 * If true, statistics of the tree (see SplayStatistics) are
+	 * collected and written for every batch as a JSON line to
+	 * a file named like the output file with ".stats" appended.
+	 */
+	bool statistics{false};
+
+	/**
+	 * Number of threads executing the batches, every thread uses its
+	 * own tree and the results are written in the original order.
+	 * Zero means one thread per hardware thread.
+	 */
+	std::size_t threads{1};
+};
+
+/**
+ * Auxiliary class that takes care of the assignment.
+ * (== parsing, control, ...)
+ */
+template<typename T, typename SplayPolicy, typename Statistics = NoSplayStatistics>
+class Task
+{
+	public:
+		/**
+		 * Constructor.
+		 * Param: Name of the input file.
+		 * Param: Name of the output file.
+		 * Param: Options of the execution.
+		 */
+		Task(const std::string& file_name, const std::string& out_file_name = "test.out",
+			 const TaskOptions& options = TaskOptions{})
+			: file_name_{file_name},
+			  output_{out_file_name},
+			  options_{options},
+			  executor_{options_}
+		{
+			if constexpr(collects_statistics_)
+				statistics_output_.open(out_file_name + ".stats");
+
+			if(options_.threads == 0)
+				options_.threads = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~Task()
+		{
+			output_.close();
+		}
+
+		/**
+		 * Parses and executes a sequence of instruction contained in
+		 * the input file.
+		 */
+		void process()
+		{
+			if(options_.threads > 1)
+			{
+				process_concurrently_();
+				return;
+			}
+
+			TraceReader<T> input{file_name_};
+			TraceBatch<T> batch{};
+			[[maybe_unused]] std::size_t index{};
+
+			while(input.next(batch))
+			{
+				executor_.execute(batch, output_);
+				if constexpr(collects_statistics_)
+					write_statistics_(index++, batch.count, executor_.statistics());
+			}
+		}
+
+		/**
+		 * Executes a sequence of instructions that has already
+		 * been read from the input file (see TraceReader::read_all),
+		 * this way the file can be parsed only once for all policies.
+		 */
+		void process(const std::vector<TraceBatch<T>>& batches)
+		{
+			auto chunk_count = std::min(batches.size(), options_.threads * chunks_per_thread_);
+			auto results = execute_chunks_(std::max(chunk_count, std::size_t{1}),
+				[&](std::size_t chunk, BatchExecutor& executor, ChunkResult& result, const auto&)
+				{
+					auto first = batches.size() * chunk / std::max(chunk_count, std::size_t{1});
+					auto last = batches.size() * (chunk + 1) / std::max(chunk_count, std::size_t{1});
+					std::ostringstream output{};
+					for(auto i = first; i < last; ++i)
+						record_(executor, batches[i], output, result);
+
+					result.output = output.str();
+					result.complete = true;
+				});
+			write_(results);
+		}
+
+	private:
+		/**
+		 * Tree and buffers used to execute batches, every
+		 * thread executing batches has its own.
+		 */
+		class BatchExecutor
+		{
+			public:
+				/**
+				 * Constructor.
+				 * Param: Options of the execution.
+				 */
+				BatchExecutor(const TaskOptions& options)
+					: options_{options}
+				{ /* DUMMY BODY */ }
+
+				/**
+				 * Executes a single batch of instructions and writes the
+				 * average find length of the batch (if it has finds).
+				 * Param: The batch.
+				 * Param: Output stream.
+				 */
+				void execute(const TraceBatch<T>& batch, std::ostream& output)
+				{
+					tree_.clear();
+					tree_.reserve(batch.count);
+					tree_.reset_statistics();
+
+					auto& inserts = batch.inserts;
+					auto sorted = inserts.begin();
+					if(options_.bulk_load)
+					{
+						sorted = tree_.is_sorted_until(inserts.begin(), inserts.end());
+						tree_.assign_sorted(inserts.begin(), sorted);
+					}
+
+					for(; sorted != inserts.end(); ++sorted)
+						tree_.insert(*sorted);
+
+					std::size_t find_length{};
+					std::size_t find_count{};
+					if(options_.reorder_finds)
+					{
+						find_results_.resize(batch.finds.size());
+						tree_.find_many(batch.finds.data(), batch.finds.size(), find_results_.data());
+
+						for(const auto& result : find_results_)
+						{
+							++find_count;
+							find_length += result.length;
+						}
+					}
+					else
+					{
+						for(const auto& key : batch.finds)
+						{
+							(void)tree_.find(key);
+
+							++find_count;
+							find_length += tree_.length_of_last_find();
+						}
+					}
+
+					if(find_count > 0)
+					{
+						auto average_length = find_length / find_count;
+						output << batch.count << " " << average_length << "\n";
+					}
+				}
+
+				/**
+				 * Returns the statistics of the last executed batch.
+				 */
+				const Statistics& statistics() const
+				{
+					return tree_.statistics();
+				}
+
+			private:
+				/**
+				 * Tree used to execute the batches, it is cleared
+				 * and reused for every batch so that its memory
+				 * gets recycled.
+				 */
+				SplayTree<T, SplayPolicy, utils::SplayComparator<T>, SlabAllocator, Statistics> tree_{};
+
+				/**
+				 * Buffer for the results of the finds of a batch
+				 * when reordering them.
+				 */
+				std::vector<FindResult> find_results_{};
+
+				/**
+				 * Options of the execution.
+				 */
+				const TaskOptions& options_;
+		};
+
+		/**
+		 * Results of a contiguous range of batches executed by a single thread.
+		 */
+		struct ChunkResult
+		{
+			/**
+			 * Lines of the output file.
+			 */
+			std::string output{};
+
+			/**
+			 * Sizes and statistics of the batches, if collected.
+			 */
+			std::vector<std::size_t> counts{};
+			std::vector<Statistics> statistics{};
+
+			/**
+			 * True if the chunk ended exactly where the next one starts.
+			 */
+			bool complete{};
+		};
+
+		/**
+		 * Executes the batches of the input file concurrently. The file is
+		 * split at batch headers found by a pre-scan, the chunks are then
+		 * parsed and executed by a pool of threads. When a chunk does not end
+		 * exactly at the header where the next one starts (which only happens
+		 * with malformed files), its thread continues to the end of the file
+		 * and the following chunks are dropped, so the output is always the
+		 * same as if the file was processed by a single thread.
+		 */
+		void process_concurrently_()
+		{
+			std::vector<std::size_t> offsets{};
+			{
+				TraceReader<T> input{file_name_};
+				auto distance = input.size() / (options_.threads * chunks_per_thread_);
+				offsets = input.batch_offsets(std::max(distance, min_chunk_size_));
+			}
+
+			auto results = execute_chunks_(offsets.size(),
+				[&](std::size_t chunk, BatchExecutor& executor, ChunkResult& result, const auto& last_chunk)
+				{
+					bool last = chunk + 1 == offsets.size();
+					TraceReader<T> input{file_name_};
+					TraceBatch<T> batch{};
+					std::ostringstream output{};
+
+					input.seek(offsets[chunk]);
+					while(chunk <= last_chunk && input.next(batch))
+					{
+						record_(executor, batch, output, result);
+						if(!last && input.at_header(offsets[chunk + 1]))
+						{
+							result.complete = true;
+							break;
+						}
+					}
+
+					result.output = output.str();
+					result.complete = result.complete || last;
+				});
+			write_(results);
+		}
+
+		/**
+		 * Executes a given number of chunks of batches by a pool of threads.
+		 * A chunk that is not complete ends the sequence, the chunks after it
+		 * are not executed (or are abandoned when already executing).
+		 * Param: Number of the chunks.
+		 * Param: Function executing a chunk, called with the index of the chunk,
+		 *        an executor, the result of the chunk and the index of the
+		 *        (currently) last chunk that is needed.
+		 */
+		template<typename Function>
+		std::vector<ChunkResult> execute_chunks_(std::size_t chunk_count, Function&& function)
+		{
+			std::vector<ChunkResult> results(chunk_count);
+			std::atomic<std::size_t> next_chunk{};
+			std::atomic<std::size_t> last_chunk{chunk_count - 1};
+
+			auto work = [&]{
+				BatchExecutor executor{options_};
+				for(auto chunk = next_chunk++; chunk < chunk_count && chunk <= last_chunk; chunk = next_chunk++)
+				{
+					function(chunk, executor, results[chunk], last_chunk);
+
+					auto last = last_chunk.load();
+					while(!results[chunk].complete && chunk < last
+						  && !last_chunk.compare_exchange_weak(last, chunk))
+					{ /* DUMMY BODY */ }
+				}
+			};
+
+			std::vector<std::thread> threads{};
+			for(std::size_t i = 1; i < std::min(options_.threads, chunk_count); ++i)
+				threads.emplace_back(work);
+			work();
+			for(auto& thread : threads)
+				thread.join();
+
+			return results;
+		}
+
+		/**
+		 * Executes a batch as a part of a chunk.
+		 */
+		void record_(BatchExecutor& executor, const TraceBatch<T>& batch,
+					 std::ostream& output, ChunkResult& result)
+		{
+			executor.execute(batch, output);
+			if constexpr(collects_statistics_)
+			{
+				result.counts.push_back(batch.count);
+				result.statistics.push_back(executor.statistics());
+			}
+		}
+
+		/**
+		 * Writes the results of the chunks in their order,
+		 * up to the first one that is not complete.
+		 */
+		void write_(const std::vector<ChunkResult>& results)
+		{
+			[[maybe_unused]] std::size_t index{};
+			for(const auto& result : results)
+			{
+				output_ << result.output;
+				if constexpr(collects_statistics_)
+				{
+					for(std::size_t i = 0; i < result.counts.size(); ++i)
+						write_statistics_(index++, result.counts[i], result.statistics[i]);
+				}
+
+				if(!result.complete)
+					break;
+			}
+		}
+
+		/**
+		 * Writes the statistics of a batch as a JSON line.
+		 * Param: Index of the batch in the file.
+		 * Param: Number of instructions of the batch.
+		 * Param: Statistics of the batch.
+		 */
+		void write_statistics_(std::size_t index, std::size_t count, const Statistics& statistics)
+		{
+			statistics_output_ << "{\"batch\":" << index << ",\"count\":" << count << ",";
+			statistics.print(statistics_output_);
+			statistics_output_ << "}\n";
+		}
+
+		/**
+		 * True if the tree collects statistics that should be written.
+		 */
+		static constexpr bool collects_statistics_{
+			!std::is_same<Statistics, NoSplayStatistics>::value
+		};
+
+		/**
+		 * Number of chunks the batches are split into per thread,
+		 * so that the threads stay busy when batches differ in size.
+		 */
+		static constexpr std::size_t chunks_per_thread_{8};
+
+		/**
+		 * Minimal size of a chunk of the input file in bytes.
+		 */
+		static constexpr std::size_t min_chunk_size_{std::size_t{1} << 16};
+
+		/**
+		 * Name of the input file.
+		 */
+		std::string file_name_;
+
+		/**
+		 * Output file stream.
+		 */
+		std::ofstream output_;
+
+		/**
+		 * Output file stream for the statistics.
+		 */
+		std::ofstream statistics_output_{};
+
+		/**
+		 * Options of the execution.
+		 */
+		TaskOptions options_;
+
+		/**
+		 * Executor of the batches when processing them
+		 * by a single thread.
+		 */
+		BatchExecutor executor_;
+};
+
+/**
+ * Performs the task with keys of a given type and a given
+ * policy, collecting statistics if the options ask for it.
+ * Param: Name of the input file.
+ * Param: Name of the output file.
+ * Param: Options of the execution.
+ * Param: Optionally, the batches of the input file if
+ *        it has already been read into memory.
+ */
+template<typename T, typename SplayPolicy, typename... Batches>
+void run_task(const std::string& input, const std::string& output,
+			  const TaskOptions& options, const Batches&... batches)
+{
+	if(options.statistics)
+	{
+		Task<T, SplayPolicy, SplayStatistics> task{input, output, options};
+		task.process(batches...);
+	}
+	else
+	{
+		Task<T, SplayPolicy> task{input, output, options};
+		task.process(batches...);
+	}
+}
+
+/**
+ * Performs the task with keys of a given type and the double rotation
+ * and naive policies, the output file of every policy is prefixed
+ * with its name.
+ * Param: Name of the input file.
+ * Param: Name of the output file.
+ * Param: Options of the execution.
+ * Param: If true, the input file is read into memory once
+ *        and the policies run in parallel.
+ * Param: If true, the top-down policy is performed as well.
+ */
+template<typename T>
+void run_tasks(const std::string& input, const std::string& output,
+			   const TaskOptions& options, bool parallel, bool top_down)
+{
+	if(parallel)
+	{
+		auto batches = TraceReader<T>{input}.read_all();
+		std::vector<std::thread> threads{};
+		threads.emplace_back([&]{ run_task<T, DoubleRotationSplayPolicy<T>>(input, "double-" + output, options, batches); });
+		threads.emplace_back([&]{ run_task<T, NaiveSplayPolicy<T>>(input, "naive-" + output, options, batches); });
+		if(top_down)
+			threads.emplace_back([&]{ run_task<T, TopDownSplayPolicy<T>>(input, "topdown-" + output, options, batches); });
+		for(auto& thread : threads)
+			thread.join();
+	}
+	else
+	{
+		run_task<T, DoubleRotationSplayPolicy<T>>(input, "double-" + output, options);
+		run_task<T, NaiveSplayPolicy<T>>(input, "naive-" + output, options);
+		if(top_down)
+			run_task<T, TopDownSplayPolicy<T>>(input, "topdown-" + output, options);
+	}
+}
+
+#if RUN_TESTS == 1
+void test();
+#endif
+
+#if RUN_BENCHMARKS == 1
+void benchmark();
+#endif
+
+/**
+ * Entry point of the program, executes tests (or benchmarks)
+ * if needed and performs the task with all policies
+ * on either a file given as the command line parameter
+ * or the file "data.txt".
+ * Options:
+ *   --bulk-load      Bulk-load sorted insert prefixes (see TaskOptions).
+ *   --reorder-finds  Look up the finds of a batch in sorted order.
+ *   --statistics     Write statistics of every batch to <output>.stats.
+ *   --parallel       Parse the file once and run the policies in parallel.
+ *   --threads <n>    Execute the batches by n threads (0 = all hardware threads).
+ *   --string-keys    Read the keys as strings instead of integers (text files only).
+ *   --top-down       Also perform the task with the top-down policy.
+ * The input file can be in the text or in the binary format (see
+ * binary_trace), instead of performing the task the program can also
+ * convert between the two:
+ *   --to-binary <in> <out>
+ *   --to-text <in> <out>
+ */
+int main(int argc, char** argv)
+{
+#if RUN_TESTS == 1
+	test();
+#endif
+#if RUN_BENCHMARKS == 1
+	benchmark();
+	return 0;
+#endif
+	std::string input{"data.txt"};
+	std::string output{};
+	TaskOptions options{};
+	bool parallel{false};
+	bool string_keys{false};
+	bool top_down{false};
+
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg{argv[i]};
+		if(arg == "--to-binary" || arg == "--to-text")
+		{
+			if(i + 2 >= argc)
+			{
+				std::cerr << "Usage: " << argv[0] << " " << arg << " <in> <out>" << std::endl;
+				return 1;
+			}
+
+			bool ok = arg == "--to-binary" ? TraceConverter::to_binary(argv[i + 1], argv[i + 2])
+										   : TraceConverter::to_text(argv[i + 1], argv[i + 2]);
+			if(!ok && arg == "--to-binary" && TraceParser{argv[i + 1]}.binary())
+				std::cerr << argv[i + 1] << " is already in the binary format." << std::endl;
+			else if(!ok)
+				std::cerr << "Conversion of " << argv[i + 1] << " failed." << std::endl;
+			return ok ? 0 : 1;
+		}
+		else if(arg == "--bulk-load")
+			options.bulk_load = true;
+		else if(arg == "--reorder-finds")
+			options.reorder_finds = true;
+		else if(arg == "--statistics")
+			options.statistics = true;
+		else if(arg == "--parallel")
+			parallel = true;
+		else if(arg == "--string-keys")
+			string_keys = true;
+		else if(arg == "--top-down")
+			top_down = true;
+		else if(arg == "--threads")
+		{
+			std::string_view count{i + 1 < argc ? argv[++i] : ""};
+			auto [end, error] = std::from_chars(count.data(), count.data() + count.size(), options.threads);
+			if(count.empty() || error != std::errc{} || end != count.data() + count.size())
+			{
+				std::cerr << "Usage: " << argv[0] << " --threads <n>, where n is a non-negative number." << std::endl;
+				return 1;
+			}
+		}
+		else
+			input = arg;
+	}
+	output = input.substr(0, input.size() - 4) + ".out";
+
+	if(string_keys)
+		run_tasks<std::string>(input, output, options, parallel, top_down);
+	else
+		run_tasks<int>(input, output, options, parallel, top_down);
+};
+
+#if RUN_BENCHMARKS == 1
+/**
+ * Keys inserted and looked up by a single benchmark run.
+ */
+struct BenchmarkWorkload
+{
+	/**
+	 * Name of the workload (see make_workload).
+	 */
+	std::string name;
+
+	/**
+	 * Keys inserted into the tree in this order.
+	 */
+	std::vector<int> inserts;
+
+	/**
+	 * Keys looked up after all inserts in this order.
+	 */
+	std::vector<int> finds;
+};
+
+/**
+ * Generator of Zipf distributed ranks in [0, n) with
+ * exponent theta, see Gray et al., Quickly Generating
+ * Billion-Record Synthetic Databases.
+ */
+class ZipfGenerator
+{
+	public:
+		/**
+		 * Constructor, precomputes the constants of the distribution
+		 * in O(n).
+		 * Param: Number of the ranks.
+		 * Param: Exponent of the distribution, it has to be in (0, 1),
+		 *        greater values make the first ranks more likely.
+		 */
+		ZipfGenerator(std::size_t n, double theta = 0.99)
+			: n_{n}, theta_{theta}, alpha_{1.0 / (1.0 - theta)},
+			  zetan_{zeta_(n, theta)}
+		{
+			eta_ = (1.0 - std::pow(2.0 / n_, 1.0 - theta_))
+				   / (1.0 - zeta_(2, theta_) / zetan_);
+		}
+
+		/**
+		 * Returns the next rank, rank 0 being the most likely one.
+		 * Param: Random number generator the rank is drawn with.
+		 */
+		template<typename Generator>
+		std::size_t operator()(Generator& rng)
+		{
+			auto u = std::uniform_real_distribution<double>{}(rng);
+			auto uz = u * zetan_;
+			if(uz < 1.0)
+				return 0;
+			if(uz < 1.0 + std::pow(0.5, theta_))
+				return std::min<std::size_t>(1, n_ - 1);
+
+			auto rank = static_cast<std::size_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+			return std::min(rank, n_ - 1);
+		}
+
+	private:
+		/**
+		 * Returns the generalized harmonic number of a given
+		 * order, i.e. the sum of 1 / i^theta for i in [1, n].
+		 * Param: Number of the summands.
+		 * Param: Exponent of the summands.
+		 */
+		static double zeta_(std::size_t n, double theta)
+		{
+			double sum{};
+			for(std::size_t i = 1; i <= n; ++i)
+				sum += 1.0 / std::pow(static_cast<double>(i), theta);
+			return sum;
+		}
+
+		/**
+		 * Number of the ranks.
+		 */
+		std::size_t n_;
+
+		/**
+		 * Exponent of the distribution.
+		 */
+		double theta_;
+
+		/**
+		 * Constants of the inversion, see the paper:
+		 * 1 / (1 - theta), zeta(n, theta) and eta.
+		 */
+		double alpha_;
+		double zetan_;
+		double eta_;
+};
+
+/**
+ * Generates a workload of a given name with a given number of keys
+ * that are looked up a given number of times:
+ *   sequential   increasing inserts and finds
+ *   uniform      random inserts, uniformly random finds
+ *   zipfian      random inserts, Zipf distributed finds
+ *   working_set  random inserts, finds from a random 1% subset
+ *   adversarial  increasing inserts, finds in bit-reversal order
+ */
+BenchmarkWorkload make_workload(const std::string& name, std::size_t size)
+{
+	std::mt19937_64 rng{size};
+	BenchmarkWorkload workload{name, std::vector<int>(size), std::vector<int>(size)};
+
+	for(std::size_t i = 0; i < size; ++i)
+		workload.inserts[i] = static_cast<int>(i);
+	if(name != "sequential" && name != "adversarial")
+		std::shuffle(workload.inserts.begin(), workload.inserts.end(), rng);
+
+	if(name == "sequential")
+		workload.finds = workload.inserts;
+	else if(name == "uniform")
+	{
+		std::uniform_int_distribution<int> dist{0, static_cast<int>(size) - 1};
+		for(auto& key : workload.finds)
+			key = dist(rng);
+	}
+	else if(name == "zipfian")
+	{ // Ranks are mapped to the (shuffled) inserted keys.
+		ZipfGenerator zipf{size};
+		for(auto& key : workload.finds)
+			key = workload.inserts[zipf(rng)];
+	}
+	else if(name == "working_set")
+	{
+		std::size_t subset = std::max<std::size_t>(1, size / 100);
+		std::uniform_int_distribution<std::size_t> dist{0, subset - 1};
+		for(auto& key : workload.finds)
+			key = workload.inserts[dist(rng)];
+	}
+	else if(name == "adversarial")
+	{
+		std::size_t bits{};
+		while((std::size_t{1} << bits) < size)
+			++bits;
+
+		std::size_t j{};
+		for(std::size_t i = 0; j < size; ++i)
+		{
+			std::size_t reversed{};
+			for(std::size_t b = 0; b < bits; ++b)
+				reversed |= ((i >> b) & 1) << (bits - b - 1);
+			if(reversed < size)
+				workload.finds[j++] = static_cast<int>(reversed);
+		}
+	}
+
+	return workload;
+}
+
+/**
+ * Resets the peak resident set size of the process, so that
+ * every run reports its own peak. (Linux only, ignored elsewhere.)
+ */
+void reset_peak_rss()
+{
+	std::ofstream clear_refs{"/proc/self/clear_refs"};
+	clear_refs << "5";
+}
+
+/**
+ * Returns the peak resident set size of the process in kB.
+ */
+std::size_t peak_rss()
+{
+	std::ifstream status{"/proc/self/status"};
+	std::string line{};
+	while(std::getline(status, line))
+	{
+		if(line.compare(0, 6, "VmHWM:") == 0)
+			return std::stoull(line.substr(6));
+	}
+	return 0;
+}
+
+/**
+ * Runs a single workload with a given splay policy and prints the
+ * results as a single line of JSON. The inserts and the finds each
+ * stop once they take more than BENCHMARK_TIME_LIMIT seconds (e.g.
+ * the naive policy is quadratic on sequential access), the results
+ * then only cover the operations performed, whose numbers are
+ * reported as well. The type of the tree can be changed
+ * (e.g. to CompactSplayTree), it has to collect SplayStatistics.
+ */
+template<
+	typename SplayPolicy,
+	typename Tree = SplayTree<int, SplayPolicy, utils::SplayComparator<int>, SlabAllocator, SplayStatistics>
+>
+void benchmark_policy(const std::string& policy, const BenchmarkWorkload& workload)
+{
+	using clock = std::chrono::steady_clock;
+	reset_peak_rss();
+
+	Tree tree{};
+	auto start = clock::now();
+	auto deadline = start + std::chrono::seconds{BENCHMARK_TIME_LIMIT};
+	std::size_t inserted{};
+	for(auto key : workload.inserts)
+	{
+		if(inserted % 1024 == 0 && clock::now() > deadline)
+			break;
+
+		tree.insert(key);
+		++inserted;
+	}
+	auto middle = clock::now();
+	tree.reset_statistics();
+
+	deadline = middle + std::chrono::seconds{BENCHMARK_TIME_LIMIT};
+	std::size_t depth{};
+	std::size_t found{};
+	std::size_t performed{};
+	for(auto key : workload.finds)
+	{
+		if(performed % 1024 == 0 && clock::now() > deadline)
+			break;
+
+		found += tree.find(key) == key;
+		depth += tree.length_of_last_find();
+		++performed;
+	}
+	auto end = clock::now();
+
+	auto insert_ns = std::chrono::duration<double, std::nano>(middle - start).count();
+	auto find_ns = std::chrono::duration<double, std::nano>(end - middle).count();
+	auto inserts = static_cast<double>(std::max<std::size_t>(inserted, 1));
+	auto finds = static_cast<double>(std::max<std::size_t>(performed, 1));
+
+	std::cout << "{\"policy\":\"" << policy << "\""
+			  << ",\"workload\":\"" << workload.name << "\""
+			  << ",\"size\":" << workload.inserts.size()
+			  << ",\"insert_ns_per_op\":" << insert_ns / inserts
+			  << ",\"find_ns_per_op\":" << find_ns / finds
+			  << ",\"throughput_ops_per_s\":" << static_cast<double>(inserted + performed) * 1e9 / (insert_ns + find_ns)
+			  << ",\"depth_per_op\":" << depth / finds
+			  << ",\"rotations_per_op\":" << tree.statistics().rotations / finds
+			  << ",\"inserts\":" << inserted
+			  << ",\"finds\":" << performed
+			  << ",\"found\":" << found
+			  << ",\"peak_rss_kb\":" << peak_rss()
+			  << "}" << std::endl;
+}
+
+/**
+ * Runs all workloads with all policies at sizes from 1e3
+ * to BENCHMARK_MAX_SIZE, the results are printed as JSON lines.
+ */
+void benchmark()
+{
+	const char* workloads[]{"sequential", "uniform", "zipfian", "working_set", "adversarial"};
+
+	for(std::size_t size = 1000; size <= BENCHMARK_MAX_SIZE; size *= 10)
+	{
+		for(auto name : workloads)
+		{
+			auto workload = make_workload(name, size);
+			benchmark_policy<DoubleRotationSplayPolicy<int>>("double", workload);
+			benchmark_policy<NaiveSplayPolicy<int>>("naive", workload);
+			benchmark_policy<TopDownSplayPolicy<int>>("topdown", workload);
+			benchmark_policy<SemiSplayPolicy<int>>("semi", workload);
+			benchmark_policy<DepthThresholdSplayPolicy<int>>("threshold", workload);
+			benchmark_policy<ProbabilisticSplayPolicy<int>>("probabilistic", workload);
+			benchmark_policy<DoubleRotationSplayPolicy<int>, CompactSplayTree<
+				int, DoubleRotationSplayPolicy<int>, utils::SplayComparator<int>, SplayStatistics
+			>>("compact-double", workload);
+			benchmark_policy<TopDownSplayPolicy<int>, CompactSplayTree<
+				int, TopDownSplayPolicy<int>, utils::SplayComparator<int>, SplayStatistics
+			>>("compact-topdown", workload);
+		}
+	}
+}
+#endif
+
+#if RUN_TESTS == 1
+bool test_1();
+bool test_2();
+bool test_3();
+bool test_4();
+bool test_5();
+bool test_6();
+bool test_7();
+bool test_8();
+bool test_9();
+bool test_10();
+bool test_11();
+bool test_12();
+bool test_13();
+bool test_14();
+bool test_15();
+bool test_16();
+bool test_17();
+bool test_18();
+bool test_19();
+bool test_20();
+bool test_21();
+bool test_22();
+bool test_23();
+bool test_24();
+bool test_25();
+bool test_26();
+bool test_27();
+bool test_28();
+
+/**
+ * A simple test suite that ensured I didn't
+ * break any functionality of the splay tree.
+ */
+void test()
+{
+	if(test_1())
+		TEST("Success.", 1);
+	else
+		TEST("Failure.", 1);
+
+	if(test_2())
+		TEST("Success.", 2);
+	else
+		TEST("Failure.", 2);
+
+	if(test_3())
+		TEST("Success.", 3);
+	else
+		TEST("Failure.", 3);
+
+	if(test_4())
+		TEST("Success.", 4);
+	else
+		TEST("Failure.", 4);
+
+	if(test_5())
+		TEST("Success.", 5);
+	else
+		TEST("Failure.", 5);
+
+	if(test_6())
+		TEST("Success.", 6);
+	else
+		TEST("Failure.", 6);
+
+	if(test_7())
+		TEST("Success.", 7);
+	else
+		TEST("Failure.", 7);
+
+	if(test_8())
+		TEST("Success.", 8);
+	else
+		TEST("Failure.", 8);
+
+	if(test_9())
+		TEST("Success.", 9);
+	else
+		TEST("Failure.", 9);
+
+	if(test_10())
+		TEST("Success.", 10);
+	else
+		TEST("Failure.", 10);
+
+	if(test_11())
+		TEST("Success.", 11);
+	else
+		TEST("Failure.", 11);
+
+	if(test_12())
+		TEST("Success.", 12);
+	else
+		TEST("Failure.", 12);
+
+	if(test_13())
+		TEST("Success.", 13);
+	else
+		TEST("Failure.", 13);
+
+	if(test_14())
+		TEST("Success.", 14);
+	else
+		TEST("Failure.", 14);
+
+	if(test_15())
+		TEST("Success.", 15);
+	else
+		TEST("Failure.", 15);
+
+	if(test_16())
+		TEST("Success.", 16);
+	else
+		TEST("Failure.", 16);
+
+	if(test_17())
+		TEST("Success.", 17);
+	else
+		TEST("Failure.", 17);
+
+	if(test_18())
+		TEST("Success.", 18);
+	else
+		TEST("Failure.", 18);
+
+	if(test_19())
+		TEST("Success.", 19);
+	else
+		TEST("Failure.", 19);
+
+	if(test_20())
+		TEST("Success.", 20);
+	else
+		TEST("Failure.", 20);
+
+	if(test_21())
+		TEST("Success.", 21);
+	else
+		TEST("Failure.", 21);
+
+	if(test_22())
+		TEST("Success.", 22);
+	else
+		TEST("Failure.", 22);
+
+	if(test_23())
+		TEST("Success.", 23);
+	else
+		TEST("Failure.", 23);
+
+	if(test_24())
+		TEST("Success.", 24);
+	else
+		TEST("Failure.", 24);
+
+	if(test_25())
+		TEST("Success.", 25);
+	else
+		TEST("Failure.", 25);
+
+	if(test_26())
+		TEST("Success.", 26);
+	else
+		TEST("Failure.", 26);
+
+	if(test_27())
+		TEST("Success.", 27);
+	else
+		TEST("Failure.", 27);
+
+	if(test_28())
+		TEST("Success.", 28);
+	else
+		TEST("Failure.", 28);
+}
+
+/**
+ * Test of the left rotation on a small input.
+ */
+bool test_1()
+{
+	/**
+	 * Nodes are statically allocated to
+	 * use RAII.
+	 */
+	Node<int> node_1{1};
+	Node<int> node_2{2};
+	Node<int> node_3{3};
+	Node<int> node_4{4};
+	Node<int> node_5{5};
+
+	/**
+	 * Building the tree for rotation:
+	 *     1          2
+	 *    / \        / \
+	 *   2  3   =>  1   5
+	 *     / \     / \
+	 *    4   5   3   4
+	 */
+	Node<int>* root{&node_1};
+	root->left = &node_2;
+	root->right = &node_3;
+	root->right->left = &node_4;
+	root->right->right = &node_5;
+
+	SplayTreeRotator<int>::rotate_left(root, &root);
+
+	bool res_root{root == &node_3};
+	bool res_left{root->left == &node_1};
+	bool res_left_left{root->left->left == &node_2};
+	bool res_left_right{root->left->right == &node_4};
+	bool res_right{root->right == &node_5};
+	
+	if(!res_root)
+	{
+		TEST("New root is incorrect: " + std::to_string(root->key)
+			 + " != 3.", 1);
+	}
+
+	if(!res_left)
+	{
+		TEST("Left child of root is incorrect: "
+			 + std::to_string(root->left->key) + " != 1.", 2);
+	}
+
+	if(!res_left_left)
+	{
+		TEST("Left-left grandchild of root is incorrect: "
+			 + std::to_string(root->left->left->key) + " != 2.", 2);
+	}
+
+	if(!res_left_right)
+	{
+		TEST("Left-right grandchild of root is incorrect: "
+			 + std::to_string(root->left->right->key) + " != 4.", 2);
+	}
+
+	if(!res_right)
+	{
+		TEST("Right child of root is incorrect: "
+			 + std::to_string(root->right->key) + " != 5.", 2);
+	}
+
+	return res_root && res_left && res_left_left
+		   && res_left_right && res_right;
+}
+
+/**
+ * Test of the right rotation on a small input.
+ */
+bool test_2()
+{
+	/**
+	 * Nodes are statically allocated to
+	 * use RAII.
+	 */
+	Node<int> node_1{1};
+	Node<int> node_2{2};
+	Node<int> node_3{3};
+	Node<int> node_4{4};
+	Node<int> node_5{5};
+
+	/**
+	 * Building the tree for rotation:
+	 *     1          2
+	 *    / \        / \
+	 *   2  3   =>  4   1
+	 *  / \            / \
+	 *  4  5          5   3
+	 */
+	Node<int>* root{&node_1};
+	root->left = &node_2;
+	root->right = &node_3;
+	root->left->left = &node_4;
+	root->left->right = &node_5;
+
+	SplayTreeRotator<int>::rotate_right(root, &root);
+
+	bool res_root{root == &node_2};
+	bool res_left{root->left == &node_4};
+	bool res_right_left{root->right->left == &node_5};
+	bool res_right_right{root->right->right == &node_3};
+	bool res_right{root->right == &node_1};
+	
+	if(!res_root)
+	{
+		TEST("New root is incorrect: " + std::to_string(root->key)
+			 + " != 3.", 1);
+	}
+
+	if(!res_left)
+	{
+		TEST("Left child of root is incorrect: "
+			 + std::to_string(root->left->key) + " != 4.", 1);
+	}
+
+	if(!res_right_left)
+	{
+		TEST("Left-left grandchild of root is incorrect: "
+			 + std::to_string(root->right->left->key) + " != 5.", 1);
+	}
+
+	if(!res_right_right)
+	{
+		TEST("Left-right grandchild of root is incorrect: "
+			 + std::to_string(root->right->right->key) + " != 3.", 1);
+	}
+
+	if(!res_right)
+	{
+		TEST("Right child of root is incorrect: "
+			 + std::to_string(root->right->key) + " != 1.", 1);
+	}
+
+	return res_root && res_left && res_right_left
+		   && res_right_right && res_right;
+}
+
+/**
+ * Simple test that checks that both contains and
+ * find functions work correctly and also checks if
+ * insert builds a correct binary search tree.
+ * NOTE: Double rotation version.
+ */
+bool test_3()
+{
+	SplayTree<int, DoubleRotationSplayPolicy<int>> tree{};
+	int test_data[] { 4, 3, 2, 1, 6, 7, 8, 5};
+
+	for(auto data : test_data)
+	{
+		tree.insert(data);
+		tree.print();
+	}
+	if(!tree.validate())
+		TEST("Tree invalid.", 3);
+
+	bool res{true};
+	for(auto data : test_data)
+	{
+		if(!tree.contains(data))
+		{
+			TEST("Tree does not contain key: " + std::to_string(data)
+				 + ".", 3);
+			res = false;
+		}
+	}
+
+	for(auto data : test_data)
+	{
+		if(tree.find(data) != data)
+		{
+			TEST("Tree find failed: " + std::to_string(data)
+				 + " != " + std::to_string(data) + ".", 3);
+			res = false;
+		}
+	}
+
+	return res;
+}
+
+/**
+ * Simple test that checks that both contains and
+ * find functions work correctly and also checks if
+ * insert builds a correct binary search tree.
+ * NOTE: Naive version.
+ */
+bool test_4()
+{
+	SplayTree<int, NaiveSplayPolicy<int>> tree{};
+	int test_data[] { 4, 3, 2, 1, 6, 7, 8, 5};
+
+	for(auto data : test_data)
+		tree.insert(data);
+	if(!tree.validate())
+		TEST("Tree invalid.", 4);
+
+	bool res{true};
+	for(auto data : test_data)
+	{
+		if(!tree.contains(data))
+		{
+			TEST("Tree does not contain key: " + std::to_string(data)
+				 + ".", 4);
+			res = false;
+		}
+	}
+
+	for(auto data : test_data)
+	{
+		if(tree.find(data) != data)
+		{
+			TEST("Tree find failed: " + std::to_string(data)
+				 + " != " + std::to_string(data) + ".", 4);
+			res = false;
+		}
+	}
+
+	return res;
+}
+
+/**
+ *
+ */
+bool test_5()
+{
+	std::string test_file{"test_x_a_b_11-_2444-_aafa.txt"};
+	std::ofstream output{test_file};
+	output << "# 3\nI 1\nI 2\nI 0\nF 1\nF 0\nF 2" << std::endl;
+
+	Task<int, DoubleRotationSplayPolicy<int>> task1{test_file};
+	task1.process();
+
+	std::remove(test_file.c_str());
+
+	return true;
+}
+
+/**
+ * Simple test that checks that both contains and
+ * find functions work correctly and also checks if
+ * insert builds a correct binary search tree.
+ * NOTE: Top-down version.
+ */
+bool test_6()
+{
+	SplayTree<int, TopDownSplayPolicy<int>> tree{};
+	int test_data[] { 4, 3, 2, 1, 6, 7, 8, 5};
+
+	for(auto data : test_data)
+		tree.insert(data);
+	if(!tree.validate())
+		TEST("Tree invalid.", 6);
+
+	bool res{true};
+	for(auto data : test_data)
+	{
+		if(!tree.contains(data))
+		{
+			TEST("Tree does not contain key: " + std::to_string(data)
+				 + ".", 6);
+			res = false;
+		}
+	}
+
+	if(tree.contains(42))
+	{
+		TEST("Tree contains a key that was not inserted.", 6);
+		res = false;
+	}
+
+	return res && tree.validate();
+}
+
+/**
+ * Checks that a cleared tree is empty and can
+ * be reused for another batch of keys.
+ */
+bool test_7()
+{
+	SplayTree<int, DoubleRotationSplayPolicy<int>> tree{};
+	tree.reserve(100);
+
+	bool res{true};
+	for(int batch = 0; batch < 3; ++batch)
+	{
+		tree.clear();
+		if(tree.contains(batch + 1))
+		{
+			TEST("Cleared tree contains key: " + std::to_string(batch + 1)
+				 + ".", 7);
+			res = false;
+		}
+
+		for(int i = 1; i <= 100; ++i)
+			tree.insert(i * (batch + 1));
+		if(!tree.validate())
+		{
+			TEST("Tree invalid after clear.", 7);
+			res = false;
+		}
+
+		for(int i = 1; i <= 100; ++i)
+		{
+			if(!tree.contains(i * (batch + 1)))
+			{
+				TEST("Tree does not contain key: "
+					 + std::to_string(i * (batch + 1)) + ".", 7);
+				res = false;
+			}
+		}
+	}
+
+	return res;
+}
+
+/**
+ * Checks that the map finds values without copying them,
+ * can distinguish misses and does not overwrite values
+ * on try_emplace.
+ */
+bool test_8()
+{
+	SplayMap<int, std::string, DoubleRotationSplayPolicy<int>> map{};
+	SplayMap<int, std::string, TopDownSplayPolicy<int>> top_down_map{};
+	int test_data[] { 4, 3, 2, 1, 6, 7, 8, 5, 0};
+
+	for(auto data : test_data)
+	{
+		map.try_emplace(data, std::to_string(data));
+		top_down_map.insert_or_assign(data, std::to_string(data));
+	}
+
+	bool res{true};
+	for(auto data : test_data)
+	{
+		auto value = map.find(data);
+		auto top_down_value = top_down_map.find(data);
+		if(!value || *value != std::to_string(data)
+		   || !top_down_value || *top_down_value != std::to_string(data))
+		{
+			TEST("Map find failed: " + std::to_string(data) + ".", 8);
+			res = false;
+		}
+	}
+
+	if(map.find(42) || top_down_map.find(42))
+	{
+		TEST("Map contains a key that was not inserted.", 8);
+		res = false;
+	}
+
+	auto emplaced = map.try_emplace(1, "one");
+	auto assigned = map.insert_or_assign(2, "two");
+	if(emplaced.second || *emplaced.first != "1"
+	   || assigned.second || *map.find(2) != "two")
+	{
+		TEST("Map overwrote or failed to assign a value.", 8);
+		res = false;
+	}
+
+	return res;
+}
+
+/**
+ * Inserts a sequence of keys, erases every other one
+ * and checks that exactly the remaining keys are present.
+ */
+template<typename SplayPolicy>
+bool test_erase(int num)
+{
+	SplayTree<int, SplayPolicy> tree{};
+	for(int i = 0; i < 100; ++i)
+		tree.insert((i * 37) % 100 + 1);
+
+	bool res{true};
+	for(int i = 2; i <= 100; i += 2)
+	{
+		if(!tree.erase(i))
+		{
+			TEST("Tree failed to erase key: " + std::to_string(i) + ".", num);
+			res = false;
+		}
+	}
+
+	if(tree.erase(2) || tree.erase(1000) || !tree.validate())
+	{
+		TEST("Tree invalid after erase.", num);
+		res = false;
+	}
+
+	for(int i = 1; i <= 100; ++i)
+	{
+		if(tree.contains(i) != (i % 2 == 1))
+		{
+			TEST("Tree contains erased or misses remaining key: "
+				 + std::to_string(i) + ".", num);
+			res = false;
+		}
+	}
+
+	return res;
+}
+
+/**
+ * Test of erase with all splay policies.
+ */
+bool test_9()
+{
+	return test_erase<DoubleRotationSplayPolicy<int>>(9)
+		&& test_erase<NaiveSplayPolicy<int>>(9)
+		&& test_erase<TopDownSplayPolicy<int>>(9);
+}
+
+/**
+ * Checks that split, join and merge move the correct
+ * keys between trees.
+ */
+template<typename SplayPolicy>
+bool test_split_join(int num)
+{
+	SplayTree<int, SplayPolicy> tree{};
+	for(int i = 1; i <= 100; ++i)
+		tree.insert((i * 37) % 100 + 1);
+
+	bool res{true};
+	auto right = tree.split(50);
+	for(int i = 1; i <= 100; ++i)
+	{
+		if(tree.contains(i) != (i < 50) || right.contains(i) != (i >= 50))
+		{
+			TEST("Split put key in a wrong tree: " + std::to_string(i) + ".", num);
+			res = false;
+		}
+	}
+
+	tree.join(right);
+	right.insert(1000);
+	for(int i = 1; i <= 100; ++i)
+	{
+		if(!tree.contains(i) || right.contains(i))
+		{
+			TEST("Join lost key: " + std::to_string(i) + ".", num);
+			res = false;
+		}
+	}
+
+	SplayTree<int, SplayPolicy> other{};
+	for(int i = 90; i <= 300; i += 3)
+		other.insert(i);
+	tree.merge(other);
+	for(int i = 1; i <= 300; ++i)
+	{
+		if(tree.contains(i) != (i <= 100 || i % 3 == 0))
+		{
+			TEST("Merge lost or invented key: " + std::to_string(i) + ".", num);
+			res = false;
+		}
+	}
+
+	return res && tree.validate() && right.contains(1000);
+}
+
+/**
+ * Comparator whose order is chosen at runtime.
+ */
+struct DirectedComparator
+{
+	template<typename N>
+	bool operator()(const N& a, int key) const
+	{
+		return descending ? a.key > key : a.key < key;
+	}
+
+	bool descending{};
+};
+
+/**
+ * Checks that the tree split off a tree with a stateful
+ * comparator keeps the comparator.
+ */
+template<typename SplayPolicy>
+bool test_split_comparator(int num)
+{
+	SplayTree<int, SplayPolicy, DirectedComparator> tree{DirectedComparator{true}};
+	for(int i = 1; i <= 100; ++i)
+		tree.insert((i * 37) % 100 + 1);
+
+	// Keys following 50 in descending order are the smaller ones.
+	bool res{true};
+	auto right = tree.split(50);
+	for(int i = 1; i <= 100; ++i)
+	{
+		if(tree.contains(i) != (i > 50) || right.contains(i) != (i <= 50))
+		{
+			TEST("Split with a comparator put key in a wrong tree: " + std::to_string(i) + ".", num);
+			res = false;
+		}
+	}
+
+	right.insert(0);
+	right.insert(25);
+	tree.join(right);
+
+	return res && right.validate() && tree.validate() && tree.contains(0) && tree.size() == 101;
+}
+
+/**
+ * Test of split, join and merge with all splay policies.
+ */
+bool test_10()
+{
+	return test_split_join<DoubleRotationSplayPolicy<int>>(10)
+		&& test_split_join<NaiveSplayPolicy<int>>(10)
+		&& test_split_join<TopDownSplayPolicy<int>>(10)
+		&& test_split_comparator<DoubleRotationSplayPolicy<int>>(10)
+		&& test_split_comparator<NaiveSplayPolicy<int>>(10)
+		&& test_split_comparator<TopDownSplayPolicy<int>>(10);
+}
+
+/**
+ * Checks that a tree built from sorted keys contains
+ * all of them, is balanced and can be used further.
+ */
+bool test_11()
+{
+	std::vector<int> keys{};
+	for(int i = 1; i <= 1000; ++i)
+		keys.push_back(i * 2);
+
+	SplayTree<int, DoubleRotationSplayPolicy<int>> tree{keys.begin(), keys.end()};
+
+	bool res{true};
+	(void)tree.find(2);
+	if(tree.length_of_last_find() > 10)
+	{
+		TEST("Tree built from sorted keys is not balanced.", 11);
+		res = false;
+	}
+
+	tree.insert(3);
+	tree.erase(4);
+	for(int i = 1; i <= 2000; ++i)
+	{
+		if(tree.contains(i) != ((i % 2 == 0 && i != 4) || i == 3))
+		{
+			TEST("Tree built from sorted keys lost key: "
+				 + std::to_string(i) + ".", 11);
+			res = false;
+		}
+	}
+
+	SplayTree<int, TopDownSplayPolicy<int>> top_down_tree{};
+	top_down_tree.insert(5);
+	top_down_tree.assign_sorted(keys.begin(), keys.end());
+	if(top_down_tree.contains(5) || !top_down_tree.contains(2000))
+	{
+		TEST("Assigning sorted keys did not replace the contents.", 11);
+		res = false;
+	}
+
+	// Keys are sorted in the order of the comparator.
+	SplayTree<int, DoubleRotationSplayPolicy<int>, DirectedComparator> descending{DirectedComparator{true}};
+	std::vector<int> reversed(keys.rbegin(), keys.rend());
+	reversed.push_back(7);
+	auto sorted = descending.is_sorted_until(reversed.begin(), reversed.end());
+	descending.assign_sorted(reversed.begin(), sorted);
+	if(sorted != reversed.end() - 1 || keys.begin() + 1 != descending.is_sorted_until(keys.begin(), keys.end())
+	   || !descending.validate() || !descending.contains(2) || descending.contains(7))
+	{
+		TEST("Tree with a comparator was built from keys in a wrong order.", 11);
+		res = false;
+	}
+
+	return res && tree.validate() && top_down_tree.validate();
+}
+
+/**
+ * Checks that a batched find reports the results
+ * in the order of the queries.
+ */
+bool test_12()
+{
+	SplayTree<int, DoubleRotationSplayPolicy<int>> tree{};
+	for(int i = 1; i <= 100; ++i)
+		tree.insert(i * 3);
+
+	std::vector<int> keys{};
+	for(int i = 300; i > 0; i -= 7)
+		keys.push_back(i);
+	std::vector<FindResult> results(keys.size());
+	tree.find_many(keys.data(), keys.size(), results.data());
+
+	bool res{true};
+	for(std::size_t i = 0; i < keys.size(); ++i)
+	{
+		if(results[i].found != (keys[i] % 3 == 0))
+		{
+			TEST("Batched find failed: " + std::to_string(keys[i]) + ".", 12);
+			res = false;
+		}
+	}
+
+	// The keys are in the order of the comparator, so they are looked up as given.
+	SplayTree<int, DoubleRotationSplayPolicy<int>, DirectedComparator> descending{DirectedComparator{true}};
+	for(int i = 1; i <= 100; ++i)
+		descending.insert(i * 3);
+	auto copy = descending.clone();
+	descending.find_many(keys.data(), keys.size(), results.data());
+	for(std::size_t i = 0; i < keys.size(); ++i)
+	{
+		bool found = copy.contains(keys[i]);
+		if(results[i].found != found || results[i].length != copy.length_of_last_find())
 		{
-			if(!node)
-				return true;
+			TEST("Batched find ignored the comparator: " + std::to_string(keys[i]) + ".", 12);
+			res = false;
+		}
+	}
 
-			if(node->left && node->left->key > node->key)
-				return false;
-			if(node->right && node->right->key < node->key)
-				return false;
-			
-			return validate_(node->right) && validate_(node->left);
+	return res && tree.validate();
+}
+
+/**
+ * Checks that the trace parser splits tokens, decodes
+ * numbers and fails like an input stream would.
+ */
+bool test_13()
+{
+	std::string test_file{"test_x_a_b_13-_2444-_aafa.txt"};
+	std::ofstream output{test_file};
+	output << "#\t3\r\n  I -42\nF +7 I 99999999999 F" << std::endl;
+	output.close();
+
+	TraceParser parser{test_file};
+	std::string_view token{};
+	int number{};
+
+	bool res{parser.next_token(token) && token == "#"};
+	res = res && parser.next_number(number) && number == 3;
+	res = res && parser.next_token(token) && token == "I";
+	res = res && parser.next_number(number) && number == -42;
+	res = res && parser.next_token(token) && token == "F";
+	res = res && parser.next_number(number) && number == 7;
+	res = res && parser.next_token(token) && token == "I";
+	res = res && !parser.next_number(number) && number == std::numeric_limits<int>::max();
+	res = res && !parser.next_token(token) && token == "I";
+
+	// Numbers that do not fit or are missing fail with the values of a stream.
+	for(std::string text : {"-99999999999", "99999999999", "x", "-"})
+	{
+		std::ofstream{test_file} << text;
+		TraceParser text_parser{test_file};
+		std::istringstream stream{text};
+		int parsed{1};
+		int streamed{1};
+		res = res && !text_parser.next_number(parsed) && !(stream >> streamed) && parsed == streamed;
+	}
+
+	std::remove(test_file.c_str());
+
+	if(!res)
+		TEST("Trace parser read an unexpected token or number.", 13);
+	return res;
+}
+
+/**
+ * Checks that a text file survives the conversion
+ * to the binary format and back.
+ */
+bool test_14()
+{
+	std::string text_file{"test_x_a_b_14-_2444-_aafa.txt"};
+	std::string binary_file{"test_x_a_b_14-_2444-_aafa.bin"};
+	std::string back_file{"test_x_a_b_14-_2444-_aafb.txt"};
+	std::string contents{"# 3\nI 1\nI -200\nI 2147483647\nF 1\nF -2147483648\n# 1\nI 0\nF 0\n"};
+
+	std::ofstream output{text_file};
+	output << contents;
+	output.close();
+
+	bool res{TraceConverter::to_binary(text_file, binary_file)};
+	TraceParser parser{binary_file};
+	res = res && parser.binary() && parser.batch_count() == 2;
+	res = res && TraceConverter::to_text(binary_file, back_file);
+
+	std::ifstream input{back_file};
+	std::string back{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+	res = res && back == contents;
+
+	// Converting the binary file again is refused.
+	std::string twice_file{"test_x_a_b_14-_2444-_aafb.bin"};
+	res = res && !TraceConverter::to_binary(binary_file, twice_file);
+	res = res && !std::ifstream{twice_file}.is_open();
+
+	std::remove(text_file.c_str());
+	std::remove(binary_file.c_str());
+	std::remove(back_file.c_str());
+
+	if(!res)
+		TEST("Conversion to the binary format and back failed.", 14);
+	return res;
+}
+
+/**
+ * Checks that the statistics count the splay steps
+ * and the rotations consistently and that they do not
+ * change the shape of the tree.
+ * Param: Number of the test.
+ * Param: Number of keys in the tree.
+ */
+template<typename SplayPolicy>
+bool test_statistics(int num, std::size_t size)
+{
+	SplayTree<int, SplayPolicy, utils::SplayComparator<int>, SlabAllocator, SplayStatistics> tree{};
+	SplayTree<int, SplayPolicy> plain{};
+
+	bool res{true};
+	for(std::size_t i = 1; i <= size; ++i)
+	{
+		tree.insert((int)i);
+		plain.insert((int)i);
+	}
+
+	tree.reset_statistics();
+	for(std::size_t i = 1; i <= size; ++i)
+	{
+		tree.find((int)((i * 7) % size + 1));
+		plain.find((int)((i * 7) % size + 1));
+		if(tree.length_of_last_find() != plain.length_of_last_find())
+		{
+			TEST("Statistics changed the length of find: " + std::to_string(i) + ".", num);
+			res = false;
 		}
+	}
 
-		/**
-		 * Finds the node whose key is the closest to a given
-		 * key.
-		 */
-		Node<T>* find_node_with_closest_key_(const T& key)
+	auto& stats = tree.statistics();
+	std::size_t histogram_total{};
+	for(auto count : stats.depth_histogram)
+		histogram_total += count;
+
+	bool consistent = stats.searches == size && histogram_total == size;
+	consistent = consistent && stats.rotations > 0 && stats.max_depth > 0;
+	if constexpr(!SplayPolicy::top_down)
+		consistent = consistent && stats.rotations == stats.zigs + 2 * (stats.zig_zigs + stats.zig_zags);
+
+	tree.reset_statistics();
+	consistent = consistent && stats.rotations == 0 && stats.searches == 0;
+	if(!consistent)
+		TEST("Splay statistics are inconsistent.", num);
+
+	return res && consistent;
+}
+
+/**
+ * Checks the statistics policy.
+ */
+bool test_15()
+{
+	return test_statistics<DoubleRotationSplayPolicy<int>>(15, 500)
+		&& test_statistics<NaiveSplayPolicy<int>>(15, 500)
+		&& test_statistics<TopDownSplayPolicy<int>>(15, 500);
+}
+
+/**
+ * Checks that executing the batches by several threads
+ * (from the file and from memory) gives the same output
+ * as executing them by a single thread.
+ */
+bool test_16()
+{
+	std::string test_file{"test_x_a_b_16-_2444-_aafa.txt"};
+	std::string serial_file{"test_x_a_b_16-_2444-_aafa.out"};
+	std::string threads_file{"test_x_a_b_16-_2444-_aafb.out"};
+	std::string memory_file{"test_x_a_b_16-_2444-_aafc.out"};
+
+	std::ofstream output{test_file};
+	for(int batch = 0; batch < 4000; ++batch)
+	{
+		int count = 10 + batch % 20;
+		output << "# " << count << "\n";
+		for(int i = 0; i < count; ++i)
+			output << "I " << (i * 7919 + batch) % 1000 << "\n";
+		for(int i = 0; i < count / 2; ++i)
+			output << "F " << (i * 31 + batch) % 1000 << "\n";
+	}
+	output.close();
+
+	TaskOptions options{};
+	options.statistics = true;
+	{
+		Task<int, DoubleRotationSplayPolicy<int>, SplayStatistics> task{test_file, serial_file, options};
+		task.process();
+	}
+
+	options.threads = 3;
+	{
+		Task<int, DoubleRotationSplayPolicy<int>, SplayStatistics> task{test_file, threads_file, options};
+		task.process();
+	}
+	{
+		Task<int, DoubleRotationSplayPolicy<int>, SplayStatistics> task{test_file, memory_file, options};
+		task.process(TraceReader<int>{test_file}.read_all());
+	}
+
+	auto read = [](const std::string& file_name){
+		std::ifstream input{file_name};
+		return std::string{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+	};
+
+	auto expected = read(serial_file);
+	auto expected_statistics = read(serial_file + ".stats");
+	bool res{!expected.empty()};
+	for(const auto& file : {serial_file, threads_file, memory_file})
+	{
+		res = res && read(file) == expected && read(file + ".stats") == expected_statistics;
+		std::remove(file.c_str());
+		std::remove((file + ".stats").c_str());
+	}
+	std::remove(test_file.c_str());
+
+	if(!res)
+		TEST("Output of several threads differs from a single thread.", 16);
+	return res;
+}
+
+/**
+ * Checks the sharded splay tree, several threads insert, look
+ * up and erase keys while the shards are being rebalanced.
+ */
+bool test_17()
+{
+	ShardedSplayTree<int, DoubleRotationSplayPolicy<int>> tree{{250, 500, 750}};
+	bool res{tree.shard_count() == 4};
+
+	std::atomic<bool> found_all{true};
+	auto work = [&](int thread){
+		std::vector<int> keys{};
+		for(int i = 1; i <= 1000; ++i)
 		{
-			find_length_ = std::size_t{};
+			if(i % 4 == thread)
+				keys.push_back(i);
+		}
 
-			auto current_node = root_;
-			auto prev_node = root_;
+		for(std::size_t i = 0; i < keys.size() / 2; ++i)
+			tree.insert(keys[i]);
+		tree.insert_many(keys.data() + keys.size() / 2, keys.size() - keys.size() / 2);
 
-			while(current_node)
-			{
-				prev_node = current_node;
-				if(current_node->key == key)
-					return current_node;
-				else if(comparator_(*current_node, key))
-					current_node = current_node->right;
-				else
-					current_node = current_node->left;
-				++find_length_;
-			}
+		std::vector<FindResult> results(keys.size());
+		tree.find_many(keys.data(), keys.size(), results.data());
+		for(std::size_t i = 0; i < keys.size(); ++i)
+		{
+			if(!results[i].found || !tree.contains(keys[i]))
+				found_all = false;
+		}
+
+		// Erase every other key.
+		std::vector<int> erased{};
+		for(std::size_t i = 0; i < keys.size(); i += 2)
+			erased.push_back(keys[i]);
+		if(tree.erase_many(erased.data(), erased.size()) != erased.size())
+			found_all = false;
+	};
+
+	std::vector<std::thread> threads{};
+	for(int i = 0; i < 4; ++i)
+		threads.emplace_back(work, i);
+	tree.rebalance({100, 900});
+	tree.rebalance({300, 400, 500, 600});
+	for(auto& thread : threads)
+		thread.join();
+
+	res = res && found_all && tree.validate();
+
+	std::vector<int> sample{};
+	for(int i = 1; i <= 1000; ++i)
+		sample.push_back(i % 50 * 20 + 1);
+	tree.rebalance(sample.data(), sample.size(), 8);
+	res = res && tree.shard_count() == 8 && tree.validate();
+
+	for(int i = 1; i <= 1000; ++i)
+	{
+		bool even = (i - 1) / 4 % 2 == 1;
+		res = res && tree.contains(i) == even;
+	}
+
+	// Shards of a descending tree hold decreasing ranges.
+	ShardedSplayTree<int, TopDownSplayPolicy<int>, DirectedComparator> descending{{250, 750, 500}, DirectedComparator{true}};
+	std::vector<int> keys{};
+	for(int i = 1; i <= 1000; ++i)
+		keys.push_back(i);
+	descending.insert_many(keys.data(), keys.size());
+	res = res && descending.boundaries() == std::vector<int>{750, 500, 250} && descending.validate();
+	descending.rebalance(keys.data(), keys.size(), 3);
+	res = res && descending.boundaries() == std::vector<int>{667, 334} && descending.validate();
+	for(int i = 0; i <= 1001; ++i)
+		res = res && descending.contains(i) == (i >= 1 && i <= 1000);
+
+	if(!res)
+		TEST("Sharded splay tree lost or misplaced keys.", 17);
+	return res;
+}
+
+/**
+ * Checks that lookups with a policy that splays partially
+ * find the keys and keep the tree valid.
+ * Param: Number of the test.
+ * Param: Number of keys in the tree.
+ */
+template<typename SplayPolicy>
+bool test_partial_splay(int num, int size)
+{
+	SplayTree<int, SplayPolicy> tree{};
+	for(int i = 1; i <= size; ++i)
+		tree.insert(i);
+
+	bool res{tree.size() == (std::size_t)size};
+	for(int i = 1; i <= size; ++i)
+	{
+		int key = (i * 7919) % size + 1;
+		res = res && tree.find(key) == key && !tree.contains(size + key);
+	}
+
+	std::vector<int> keys{};
+	for(int i = 1; i <= 2 * size; i += 3)
+		keys.push_back(i);
+	std::vector<FindResult> results(keys.size());
+	tree.find_many(keys.data(), keys.size(), results.data());
+	for(std::size_t i = 0; i < keys.size(); ++i)
+		res = res && results[i].found == (keys[i] <= size);
+
+	auto right = tree.split(size / 2);
+	res = res && tree.size() + right.size() == (std::size_t)size;
+	tree.join(right);
+	res = res && tree.size() == (std::size_t)size && tree.validate();
+
+	return res && test_erase<SplayPolicy>(num) && test_split_join<SplayPolicy>(num);
+}
+
+/**
+ * Checks the semi-splay, depth threshold and probabilistic policies.
+ */
+bool test_18()
+{
+	bool res{true};
+	res = res && test_partial_splay<SemiSplayPolicy<int>>(18, 500);
+	res = res && test_partial_splay<DepthThresholdSplayPolicy<int>>(18, 500);
+	res = res && test_partial_splay<ProbabilisticSplayPolicy<int>>(18, 500);
+
+	// Semi-splaying the bottom of a path roughly halves its depth.
+	SplayTree<int, SemiSplayPolicy<int>> semi{};
+	for(int i = 1; i <= 64; ++i)
+		semi.insert(i);
+	semi.find(1);
+	auto path = semi.length_of_last_find();
+	semi.find(1);
+	res = res && path > 32 && semi.length_of_last_find() <= path / 2 + 1;
+
+	// Nodes of a balanced tree are never too deep.
+	std::vector<int> keys{};
+	for(int i = 1; i <= 1023; ++i)
+		keys.push_back(i);
+	SplayTree<int, DepthThresholdSplayPolicy<int>, utils::SplayComparator<int>,
+			  SlabAllocator, SplayStatistics> balanced{keys.begin(), keys.end()};
+	for(auto key : keys)
+		balanced.find(key);
+	res = res && balanced.statistics().rotations == 0 && balanced.statistics().searches == 1023;
+
+	// Trees with the same seed splay the same nodes.
+	SplayTree<int, ProbabilisticSplayPolicy<int>> first{};
+	SplayTree<int, ProbabilisticSplayPolicy<int>> second{};
+	std::size_t splayed{};
+	for(int i = 1; i <= 1000; ++i)
+	{
+		first.insert(i * 37 % 1000);
+		second.insert(i * 37 % 1000);
+	}
+	for(int i = 1; i <= 1000; ++i)
+	{
+		first.find(i * 101 % 1000);
+		second.find(i * 101 % 1000);
+		res = res && first.length_of_last_find() == second.length_of_last_find();
+		first.find(i * 101 % 1000);
+		second.find(i * 101 % 1000);
+		splayed += first.length_of_last_find() == 0;
+	}
+	res = res && splayed > 300 && splayed < 700;
+
+	if(!res)
+		TEST("Partial splay policies failed.", 18);
+	return res;
+}
+
+/**
+ * Checks a compact tree with a given policy against
+ * a tree with plain nodes.
+ */
+template<typename SplayPolicy>
+bool test_compact(int num)
+{
+	CompactSplayTree<int, SplayPolicy> compact{};
+	SplayTree<int, SplayPolicy> plain{};
+	compact.reserve(num / 2);
+
+	bool res{true};
+	for(int i = 1; i <= num; ++i)
+	{
+		int key = (i * 7919) % num + 1;
+		compact.insert(key);
+		plain.insert(key);
+	}
+
+	for(int i = 1; i <= num; i += 2)
+	{
+		res = res && compact.erase(i) == plain.erase(i);
+		res = res && !compact.erase(i) && !plain.erase(i);
+	}
+
+	// Reuses the erased nodes.
+	for(int i = 1; i <= num; i += 4)
+		compact.insert(i), plain.insert(i);
+
+	for(int i = 1; i <= 2 * num; ++i)
+	{
+		int key = (i * 31) % (2 * num);
+		res = res && compact.find(key) == plain.find(key);
+		res = res && compact.length_of_last_find() == plain.length_of_last_find();
+	}
+	res = res && compact.size() == plain.size() && compact.validate();
+
+	// Split trees share the array, joining trees of different arrays moves the nodes.
+	auto right = compact.split(num / 2);
+	res = res && compact.validate() && right.validate();
+	compact.join(right);
+	CompactSplayTree<int, SplayPolicy> other{};
+	for(int i = num + 1; i <= 2 * num; ++i)
+		other.insert(i), plain.insert(i);
+	compact.join(other);
+	res = res && other.empty() && compact.size() == plain.size() && compact.validate();
+	if constexpr(!SplayPolicy::top_down)
+		res = res && std::equal(compact.begin(), compact.end(), plain.begin(), plain.end());
+
+	compact.clear();
+	res = res && compact.empty() && compact.size() == 0 && !compact.contains(1);
+
+	return res;
+}
+
+/**
+ * Checks the compact trees.
+ */
+bool test_19()
+{
+	bool res{sizeof(CompactNode<int>) * 2 == sizeof(Node<int>)};
+	res = res && test_compact<DoubleRotationSplayPolicy<int>>(1000);
+	res = res && test_compact<NaiveSplayPolicy<int>>(1000);
+	res = res && test_compact<TopDownSplayPolicy<int>>(1000);
+	res = res && test_compact<SemiSplayPolicy<int>>(1000);
+	res = res && test_compact<DepthThresholdSplayPolicy<int>>(1000);
+	res = res && test_compact<ProbabilisticSplayPolicy<int>>(1000);
+
+	if(!res)
+		TEST("Compact splay tree differs from the plain one.", 19);
+	return res;
+}
+
+/**
+ * Comparator that counts the comparisons it makes.
+ */
+struct CountingComparator
+{
+	inline static std::size_t count{};
+
+	template<typename N>
+	bool operator()(const N& a, int key) const
+	{
+		++count;
+		return a.key < key;
+	}
+
+	template<typename N>
+	int compare(const N& a, int key) const
+	{
+		++count;
+		return utils::three_way_compare(a.key, key);
+	}
+};
+
+/**
+ * Comparator that orders the keys in decreasing order and
+ * provides no three-way compare.
+ */
+struct GreaterComparator
+{
+	template<typename N>
+	bool operator()(const N& a, int key) const
+	{
+		return a.key > key;
+	}
+};
+
+/**
+ * Checks that a successful find with a given policy compares
+ * every node on the search path only once (plus once more to
+ * check the result).
+ */
+template<typename SplayPolicy>
+bool test_comparisons(int num)
+{
+	SplayTree<int, SplayPolicy, CountingComparator> tree{};
+	for(int i = 1; i <= num; ++i)
+		tree.insert((i * 7919) % num + 1);
+
+	bool res{true};
+	for(int i = 1; i <= num; ++i)
+	{
+		int key = (i * 31) % num + 1;
+		CountingComparator::count = 0;
+		res = res && tree.find(key) == key;
+		res = res && CountingComparator::count == tree.length_of_last_find() + 2;
+	}
+
+	CompactSplayTree<int, SplayPolicy, CountingComparator> compact{};
+	for(int i = 1; i <= num; ++i)
+		compact.insert((i * 7919) % num + 1);
+	for(int i = 1; i <= num; ++i)
+	{
+		int key = (i * 31) % num + 1;
+		CountingComparator::count = 0;
+		res = res && compact.contains(key);
+		res = res && CountingComparator::count == compact.length_of_last_find() + 2;
+	}
+
+	SplayTree<int, SplayPolicy, GreaterComparator> greater{};
+	for(int i = 1; i <= num; ++i)
+		greater.insert(i);
+	res = res && greater.validate() && greater.contains(num / 2) && !greater.contains(num + 1);
+
+	return res && tree.validate() && compact.validate();
+}
+
+/**
+ * Test of the three-way comparisons and of lookups with
+ * other key types than the one stored.
+ */
+bool test_20()
+{
+	bool res{true};
+	res = res && test_comparisons<DoubleRotationSplayPolicy<int>>(1000);
+	res = res && test_comparisons<NaiveSplayPolicy<int>>(1000);
+	res = res && test_comparisons<TopDownSplayPolicy<int>>(1000);
+	res = res && test_comparisons<SemiSplayPolicy<int>>(1000);
+	res = res && test_comparisons<DepthThresholdSplayPolicy<int>>(1000);
+	res = res && test_comparisons<ProbabilisticSplayPolicy<int>>(1000);
+
+	SplayTree<std::string, TopDownSplayPolicy<std::string>> tree{};
+	SplayMap<std::string, int, DoubleRotationSplayPolicy<std::string>> map{};
+	for(const char* key : {"/index", "/about", "/blog/1", "/blog/2", "/contact"})
+	{
+		tree.insert(key);
+		map.try_emplace(key, static_cast<int>(std::strlen(key)));
+	}
+
+	std::string_view path{"/blog/2/comments"};
+	res = res && tree.contains(path.substr(0, 7)) && !tree.contains(path);
+	res = res && tree.find(path.substr(0, 6)).empty() && tree.find("/about") == "/about";
+	res = res && tree.erase(std::string_view{"/index"}) && !tree.contains("/index");
+	res = res && tree.size() == 4 && tree.validate();
+
+	auto value = map.find(path.substr(0, 7));
+	res = res && value && *value == 7 && !map.find(path) && map.erase(std::string_view{"/blog/1"});
+	res = res && !map.contains("/blog/1") && map.contains("/blog/2");
+
+	if(!res)
+		TEST("Three-way comparisons or heterogeneous lookups failed.", 20);
+	return res;
+}
+
+/**
+ * Checks a tree with string keys of a given type, the keys
+ * are created from strings by a given function.
+ */
+template<typename SplayPolicy, typename Key, typename Function>
+bool test_string_keys(const std::vector<std::string>& strings, Function make_key)
+{
+	SplayTree<Key, SplayPolicy> tree{};
+	for(std::size_t i = 0; i < strings.size(); i += 2)
+		tree.insert(make_key(strings[i]));
+	tree.print();
+
+	bool res{tree.validate()};
+	for(std::size_t i = 0; i < strings.size(); ++i)
+	{
+		std::string_view key{strings[i]};
+		res = res && tree.contains(key) == (i % 2 == 0);
+	}
+	for(std::size_t i = 0; i < strings.size(); i += 4)
+		res = res && tree.erase(std::string_view{strings[i]});
+
+	return res && tree.size() == (strings.size() + 1) / 2 - (strings.size() + 3) / 4 && tree.validate();
+}
+
+/**
+ * Test of string keys, of the arena strings and of tasks
+ * with string keys.
+ */
+bool test_21()
+{
+	std::vector<std::string> strings{"", "/", "/a", "/ab", "/abc", "/abcd", "/api/v1/users"};
+	for(int i = 0; i < 500; ++i)
+	{
+		strings.push_back("/api/v1/users/" + std::to_string(i * 7919 % 1000) + "/profile");
+		strings.push_back("/" + std::to_string(i * 31 % 1000));
+	}
+
+	bool res{sizeof(ArenaString) == 16};
+	StringArena arena{};
+	std::vector<ArenaString> keys{};
+	for(const auto& string : strings)
+		keys.emplace_back(string, arena);
+	res = res && arena.block_count() == 1;
+
+	for(std::size_t i = 0; i < strings.size(); ++i)
+	{
+		res = res && keys[i].view() == strings[i] && utils::to_string(keys[i]) == strings[i];
+		for(std::size_t j = i; j < strings.size(); j += 97)
+		{
+			auto expected = strings[i].compare(strings[j]);
+			auto actual = keys[i].compare(keys[j]);
+			res = res && (expected < 0) == (actual < 0) && (expected > 0) == (actual > 0);
+			res = res && (keys[i] == keys[j]) == (strings[i] == strings[j]);
+			res = res && (keys[i] < std::string_view{strings[j]}) == (strings[i] < strings[j]);
+		}
+	}
+
+	auto make_string = [](const std::string& string){ return string; };
+	auto make_arena_string = [&arena](const std::string& string){ return ArenaString{string, arena}; };
+	res = res && test_string_keys<DoubleRotationSplayPolicy<std::string>, std::string>(strings, make_string);
+	res = res && test_string_keys<TopDownSplayPolicy<std::string>, std::string>(strings, make_string);
+	res = res && test_string_keys<DoubleRotationSplayPolicy<ArenaString>, ArenaString>(strings, make_arena_string);
+	res = res && test_string_keys<TopDownSplayPolicy<ArenaString>, ArenaString>(strings, make_arena_string);
+	res = res && test_string_keys<SemiSplayPolicy<ArenaString>, ArenaString>(strings, make_arena_string);
+
+	// Zero padded keys are ordered the same way as numbers and as strings.
+	std::string test_file{"test_x_a_b_21-_2444-_aafa.txt"};
+	std::string number_file{"test_x_a_b_21-_2444-_aafa.out"};
+	std::string string_file{"test_x_a_b_21-_2444-_aafb.out"};
+
+	std::ofstream output{test_file};
+	for(int batch = 0; batch < 100; ++batch)
+	{
+		int count = 10 + batch;
+		output << "# " << count << "\n";
+		for(int i = 0; i < count; ++i)
+			output << "I " << std::to_string(1000000 + (i * 7919 + batch) % 1000).substr(1) << "\n";
+		for(int i = 0; i < count / 2; ++i)
+			output << "F " << std::to_string(1000000 + (i * 31 + batch) % 1000).substr(1) << "\n";
+	}
+	output.close();
+
+	TaskOptions options{};
+	{
+		Task<int, TopDownSplayPolicy<int>> task{test_file, number_file, options};
+		task.process();
+	}
+	{
+		Task<std::string, TopDownSplayPolicy<std::string>> task{test_file, string_file, options};
+		task.process();
+	}
+
+	auto read = [](const std::string& file_name){
+		std::ifstream input{file_name};
+		return std::string{std::istreambuf_iterator<char>{input}, std::istreambuf_iterator<char>{}};
+	};
+	res = res && !read(number_file).empty() && read(number_file) == read(string_file);
+	for(const auto& file : {test_file, number_file, string_file})
+		std::remove(file.c_str());
+
+	// Sorted inserts build a path, which has to be destroyed without recursion.
+	{
+		SplayTree<std::string, DoubleRotationSplayPolicy<std::string>> path{};
+		for(int i = 0; i < 1000000; ++i)
+			path.insert(std::to_string(10000000 + i));
+		res = res && path.size() == 1000000;
+	}
+
+	if(!res)
+		TEST("String keys failed.", 21);
+	return res;
+}
+
+/**
+ * Checks that a range scan with a given policy visits the right
+ * keys and restructures the tree only as much as a find of its
+ * lower boundary does.
+ */
+template<typename SplayPolicy>
+bool test_range_scan(int num)
+{
+	SplayTree<int, SplayPolicy> scanned{};
+	SplayTree<int, SplayPolicy> searched{};
+	for(int i = 1; i <= num; ++i)
+	{
+		int key = 2 * ((i * 7919) % num + 1);
+		scanned.insert(key);
+		searched.insert(key);
+	}
 
-			return prev_node;
-		}
+	bool res{true};
+	for(int i = 1; i <= num; i += 37)
+	{
+		int low = (i * 31) % (2 * num), high = low + i;
+		std::vector<int> keys{};
+		scanned.for_each_in_range(low, high, [&keys](const int& key){ keys.push_back(key); });
+		searched.find(low);
 
-		/**
-		 * Prints a single node and its subtree.
-		 */
-		std::string print_(Node<T>* node) const
+		int expected = low + (low % 2) + (low == 0 ? 2 : 0);
+		for(auto key : keys)
 		{
-			if(node)
-			{
-				/**
-				 * And then God said "Let there be Lisp!", and he
-				 * saw it good.
-				 */
-				return std::to_string(node->key) +
-					   (node->left || node->right ? " " : "") + 
-					   (node->left ? "L(" + print_(node->left) + ")" : "") +
-					   (node->right ? "R(" + print_(node->right) + ")" : "");
-			}
-			else
-				return "";
+			res = res && key == expected;
+			expected += 2;
 		}
+		res = res && (expected > high || expected > 2 * num);
+	}
 
-		/**
-		 * Deletes a single node and its subtree.
-		 * (Deleting root_ effectively deallocates the tree.)
-		 */
-		void delete_(Node<T>* node)
-		{
-			if(!node)
-				return;
-			if(node->left)
-			{
-				delete_(node->left);
-				delete node->left;
-			}
-			if(node->right)
-			{
-				delete_(node->right);
-				delete node->right;
-			}
-		}
+	for(int i = 1; i <= num; ++i)
+	{
+		int key = (i * 13) % (2 * num);
+		res = res && scanned.contains(key) == searched.contains(key);
+		res = res && scanned.length_of_last_find() == searched.length_of_last_find();
+	}
 
-		/**
-		 * Variable keeping track of the length of the last traversal.
-		 */
-		std::size_t find_length_;
-};
+	int count{};
+	scanned.for_each_in_range(2 * num + 1, 4 * num, [&count](const int&){ ++count; });
+	scanned.for_each_in_range(-10, 1, [&count](const int&){ ++count; });
+	scanned.for_each_in_range(1, 2 * num, [&count](const int&){ ++count; });
+
+	return res && count == num;
+}
 
 /**
- * Auxiliary class implementing rotations on splay trees, this approach was
- * chosen to avoid unnecessary use of inheritance.
- * Note: Comments talking about movement, root and pivot, alpha, beta and gamma
- *       are all refering to this gif:
- *       https://upload.wikimedia.org/wikipedia/commons/3/31/Tree_rotation_animation_250x250.gif
- *       This is because, to this day, tree rotations confuse me.
- *       (I know, I know, shameful.)
+ * Checks the iterators of a tree with a given policy.
  */
-template<typename T>
-struct SplayTreeRotator
+template<typename SplayPolicy>
+bool test_iterators(int num)
 {
-	/**
-	 * Performs a left rotation around the given node.
-	 * Param: Root of the rotated subtree.
-	 * Param: Root of the entire tree.
-	 */
-	static void rotate_left(Node<T>* node, Node<T>** tree_root)
+	SplayTree<int, SplayPolicy> tree{};
+	bool res{tree.begin() == tree.end()};
+	for(int i = 1; i <= num; ++i)
+		tree.insert(2 * ((i * 7919) % num + 1));
+
+	int expected{2};
+	for(auto key : tree)
 	{
-		if(!node || !tree_root || !(*tree_root))
-			return;
+		res = res && key == expected;
+		expected += 2;
+	}
+	res = res && expected == 2 * num + 2 && std::distance(tree.begin(), tree.end()) == num;
 
-		auto right = node->right; // Pivot.
-		if(right)
-		{
-			// Beta horizontal movement.
-			if(right->left)
-				right->left->parent = node;
-			node->right = right->left;
+	auto it = tree.end();
+	for(int key = 2 * num; key >= 2; key -= 2)
+		res = res && *--it == key;
+	res = res && it == tree.begin();
 
-			// Swap of root and pivot.
-			right->left = node;
-			right->parent = node->parent;
-		}
+	it = tree.lower_bound(101);
+	auto next = tree.upper_bound(102);
+	res = res && *it == 102 && *next == 104 && *tree.lower_bound(102) == 102;
+	res = res && tree.lower_bound(2 * num + 1) == tree.end() && tree.upper_bound(0) == tree.begin();
 
-		// Finnish the swap of root and pivot,
-		// i.e. update root or children of root's
-		// parent.
-		if(!node->parent)
-			(*tree_root) = right;
-		else if(utils::is_left_son(node))
-			node->parent->left = right;
-		else
-			node->parent->right = right;
-		node->parent = right;
+	// Splaying keeps the order of the nodes.
+	for(int i = 1; i <= num; ++i)
+		tree.find((i * 31) % (2 * num));
+	res = res && *it++ == 102 && *it == 104 && *--it == 102 && it != next;
+
+	tree.erase(104);
+	res = res && *++it == 106;
+	auto right = tree.split(2 * (num / 2));
+	res = res && *--tree.end() == 2 * (num / 2) - 2 && *right.begin() == 2 * (num / 2);
+	tree.join(right);
+	res = res && std::distance(tree.begin(), tree.end()) == num - 1;
+
+	return res && tree.validate() && test_range_scan<SplayPolicy>(num);
+}
+
+/**
+ * Test of iterators and range scans.
+ */
+bool test_22()
+{
+	bool res{true};
+	res = res && test_iterators<DoubleRotationSplayPolicy<int>>(1000);
+	res = res && test_iterators<NaiveSplayPolicy<int>>(1000);
+	res = res && test_iterators<SemiSplayPolicy<int>>(1000);
+	res = res && test_iterators<DepthThresholdSplayPolicy<int>>(1000);
+	res = res && test_iterators<ProbabilisticSplayPolicy<int>>(1000);
+	res = res && test_range_scan<TopDownSplayPolicy<int>>(1000);
+
+	SplayTree<int, DoubleRotationSplayPolicy<int>> tree{};
+	std::vector<int> keys{1, 2, 3, 5, 8, 13, 21};
+	tree.assign_sorted(keys.begin(), keys.end());
+	res = res && std::equal(tree.begin(), tree.end(), keys.begin(), keys.end());
+
+	if(!res)
+		TEST("Iterators or range scans failed.", 22);
+	return res;
+}
+
+/**
+ * Checks an order statistic tree with a given policy.
+ */
+template<typename SplayPolicy>
+bool test_order_statistics(int num)
+{
+	OrderStatisticSplayTree<int, SplayPolicy> tree{};
+	for(int i = 1; i <= num; ++i)
+		tree.insert(2 * ((i * 7919) % num + 1));
+
+	bool res{tree.size() == (std::size_t)num && tree.validate()};
+	for(int i = 0; i < num; ++i)
+	{
+		int index = (i * 31) % num;
+		res = res && tree.select(index) == 2 * index + 2;
+		res = res && tree.rank(2 * index + 2) == (std::size_t)index;
+		res = res && tree.rank(2 * index + 1) == (std::size_t)index;
 	}
+	res = res && tree.rank(0) == 0 && tree.rank(2 * num + 1) == (std::size_t)num;
 
-	/**
-	 * Performs a right rotation around the given node.
-	 * Param: Root of the rotated subtree.
-	 * Param: Root of the entire tree.
-	 */
-	static void rotate_right(Node<T>* node, Node<T>** tree_root)
+	for(int i = 0; i < num; i += 7)
 	{
-		if(!node || !tree_root)
-			return;
-	
-		auto left = node->left; // Pivot.
-		if(left)
-		{
-			// Beta horizontal movement.
-			if(left->right)
-				left->right->parent = node;
-			node->left = left->right;
+		int low = (i * 13) % (2 * num), high = low + i;
+		std::size_t expected{};
+		tree.for_each_in_range(low, high, [&expected](const int&){ ++expected; });
+		res = res && tree.count_in_range(low, high) == expected;
+	}
+	res = res && tree.count_in_range(10, 5) == 0 && tree.count_in_range(-5, 4 * num) == (std::size_t)num;
 
-			// Swap of root and pivot.
-			left->right = node;
-			left->parent = node->parent;
-		}
+	for(int i = 2; i <= 2 * num; i += 6)
+		tree.erase(i);
+	auto right = tree.split(num);
+	res = res && right.validate() && tree.validate() && right.rank(2 * num + 1) == right.size();
+	int max = (2 * num - 2) % 6 == 0 ? 2 * num - 2 : 2 * num;
+	res = res && tree.select(0) == 4 && right.select(right.size() - 1) == max;
+	tree.join(right);
+	auto erased = (std::size_t)(2 * num + 4) / 6;
+	res = res && tree.size() == num - erased && tree.validate();
 
-		// Finnish the swap of root and pivot,
-		// i.e. update root or children of root's
-		// parent.
-		if(!node->parent)
-			(*tree_root) = left;
-		else if(utils::is_left_son(node))
-			node->parent->left = left;
-		else
-			node->parent->right = left;
-		node->parent = left;
+	OrderStatisticSplayTree<int, SplayPolicy> other{};
+	std::vector<int> keys{};
+	for(int i = 1; i <= 2 * num; i += 2)
+		keys.push_back(i);
+	other.assign_sorted(keys.begin(), keys.end());
+	res = res && other.validate() && other.select(num / 2) == 2 * (num / 2) + 1;
+	tree.merge(other);
+	res = res && tree.size() == 2 * num - erased && tree.validate();
+
+	bool thrown{false};
+	try
+	{
+		tree.select(tree.size());
+	}
+	catch(const std::out_of_range&)
+	{
+		thrown = true;
 	}
-};
+
+	return res && thrown && tree.validate();
+}
 
 /**
- * Standard implementation of the splay operation using the
- * zig, zigzig and zigzag step during propagation.
+ * Test of the order statistic trees.
  */
-template<typename T>
-struct DoubleRotationSplayPolicy
+bool test_23()
 {
-	/**
-	 * Propagates a given node to the top of the tree.
-	 */
-	static void splay(Node<T>* node, Node<T>** root)
+	bool res{true};
+	res = res && test_order_statistics<DoubleRotationSplayPolicy<int>>(1000);
+	res = res && test_order_statistics<NaiveSplayPolicy<int>>(1000);
+	res = res && test_order_statistics<TopDownSplayPolicy<int>>(1000);
+	res = res && test_order_statistics<SemiSplayPolicy<int>>(1000);
+	res = res && test_order_statistics<DepthThresholdSplayPolicy<int>>(1000);
+	res = res && test_order_statistics<ProbabilisticSplayPolicy<int>>(1000);
+
+	if(!res)
+		TEST("Order statistics failed.", 23);
+	return res;
+}
+
+/**
+ * Aggregate that concatenates the keys, it is not commutative,
+ * so it checks that the keys are combined in order.
+ */
+struct ConcatenationAggregate
+{
+	using value_type = std::string;
+
+	static value_type identity()
 	{
-		if(!node || !root || !node->parent)
-			return;
+		return value_type{};
+	}
 
-		while(node->parent)
-		{
-			if(utils::is_son_of_root(node))
-			{ // Zig.
-				if(utils::is_left_son(node))
-					SplayTreeRotator<T>::rotate_right(node->parent, root);
-				else
-					SplayTreeRotator<T>::rotate_left(node->parent, root);
-			}
-			else if(utils::is_left_son_of_left_son(node))
-			{ // Zig-zig.
-				SplayTreeRotator<T>::rotate_right(node->parent->parent, root);
-				SplayTreeRotator<T>::rotate_right(node->parent, root);
-			}
-			else if(utils::is_right_son_of_right_son(node))
-			{ // Zig-zig 2: Zig-zig harder.
-				SplayTreeRotator<T>::rotate_left(node->parent->parent, root);
-				SplayTreeRotator<T>::rotate_left(node->parent, root);
-			}
-			else if(utils::is_left_son_of_right_son(node))
-			{ // Zig-zag.
-				SplayTreeRotator<T>::rotate_right(node->parent, root);
-				SplayTreeRotator<T>::rotate_left(node->parent, root);
-			
-			}
-			else if(utils::is_right_son_of_left_son(node))
-			{ // Zig-zag 2: The Zigpocalypse.
-				SplayTreeRotator<T>::rotate_left(node->parent, root);
-				SplayTreeRotator<T>::rotate_right(node->parent, root);
-			}
-			else
-				DEBUG("Splay operation reached undefined state of nodes.");
-		}
+	static value_type of(int key)
+	{
+		return std::to_string(key) + ",";
+	}
+
+	static value_type combine(const value_type& a, const value_type& b)
+	{
+		return a + b;
 	}
 };
 
 /**
- * Naive implementation of the splay operation using a sequence of simple
- * rotations.
+ * Checks the range aggregates of trees with a given policy
+ * against the aggregates computed from a range scan.
  */
-template<typename T>
-struct NaiveSplayPolicy
+template<typename SplayPolicy>
+bool test_aggregates(int num)
 {
-	/**
-	 * Propagates a given node to the top of the tree.
-	 */
-	static void splay(Node<T>* node, Node<T>** root)
+	AggregateSplayTree<int, SplayPolicy, SumAggregate<long long>> sums{};
+	AggregateSplayTree<int, SplayPolicy, MinAggregate<int>> minima{};
+	AggregateSplayTree<int, SplayPolicy, MaxAggregate<int>> maxima{};
+	AggregateSplayTree<int, SplayPolicy, ConcatenationAggregate> concatenations{};
+	SplayTree<int, SplayPolicy> keys{};
+	for(int i = 1; i <= num; ++i)
 	{
-		if(!node || !root || !node->parent)
-			return;
+		int key = (i * 7919) % (3 * num) + 1;
+		sums.insert(key), minima.insert(key), maxima.insert(key);
+		concatenations.insert(key), keys.insert(key);
+	}
+	for(int i = 1; i <= 3 * num; i += 5)
+	{
+		sums.erase(i), minima.erase(i), maxima.erase(i);
+		concatenations.erase(i), keys.erase(i);
+	}
 
-		while(node->parent)
-		{
-			if(utils::is_left_son(node))
-				SplayTreeRotator<T>::rotate_right(node->parent, root);
-			else
-				SplayTreeRotator<T>::rotate_left(node->parent, root);
-		}
+	auto right = sums.split(num);
+	sums.join(right);
+
+	bool res{sums.validate() && minima.validate() && maxima.validate() && concatenations.validate()};
+	for(int i = 0; i < num; ++i)
+	{
+		int low = (i * 31) % (3 * num), high = low + (i * 17) % num - num / 4;
+		long long sum{};
+		int min = std::numeric_limits<int>::max(), max = std::numeric_limits<int>::lowest();
+		std::string concatenation{};
+		keys.for_each_in_range(low, high, [&](const int& key){
+			sum += key;
+			min = std::min(min, key);
+			max = std::max(max, key);
+			concatenation += std::to_string(key) + ",";
+		});
+
+		res = res && sums.aggregate(low, high) == sum;
+		res = res && minima.aggregate(low, high) == min && maxima.aggregate(low, high) == max;
+		res = res && concatenations.aggregate(low, high) == concatenation;
 	}
-};
+
+	return res && sums.validate() && concatenations.validate() && sums.aggregate(1, 0) == 0;
+}
 
 /**
- * Auxiliary class that takes care of the assignment.
- * (== parsing, control, ...)
+ * Test of the range aggregates.
  */
-template<typename T, typename SplayPolicy>
-class Task
+bool test_24()
 {
-	public:
-		/**
-		 * Constructor.
-		 * Param: Name of the input file.
-		 * Param: Name of the output file.
-		 */
-		Task(const std::string& file_name, const std::string& out_file_name = "test.out")
-			: input_{file_name},
-			  output_{out_file_name}
-		{ /* DUMMY BODY */ }
+	bool res{true};
+	res = res && test_aggregates<DoubleRotationSplayPolicy<int>>(500);
+	res = res && test_aggregates<NaiveSplayPolicy<int>>(500);
+	res = res && test_aggregates<TopDownSplayPolicy<int>>(500);
+	res = res && test_aggregates<SemiSplayPolicy<int>>(500);
+	res = res && test_aggregates<DepthThresholdSplayPolicy<int>>(500);
+	res = res && test_aggregates<ProbabilisticSplayPolicy<int>>(500);
 
-		/**
-		 * Destructor.
-		 */
-		~Task()
-		{
-			input_.close();
-			output_.close();
-		}
+	AggregateSplayTree<int, DoubleRotationSplayPolicy<int>, SumAggregate<long long>> tree{};
+	res = res && tree.aggregate(1, 10) == 0;
 
-		/**
-		 * Parses and executes a sequence of instruction contained in
-		 * the input file.
-		 */
-		void process()
-		{
-			std::string token{};
-			std::size_t count{};
+	if(!res)
+		TEST("Range aggregates failed.", 24);
+	return res;
+}
+
+/**
+ * Test of the splay sequence, checks the lazy range operations
+ * against a vector.
+ */
+bool test_25()
+{
+	int num{2000};
+	std::vector<int> model{};
+	for(int i = 0; i < num; ++i)
+		model.push_back(i);
+	SplaySequence<int> sequence{model.begin(), model.end()};
+
+	bool res{sequence.validate() && sequence.size() == model.size()};
+	for(int i = 0; i < num; ++i)
+	{
+		std::size_t size = model.size();
+		std::size_t first = (i * 7919) % (size + 1), last = (i * 104729) % (size + 1);
+		if(first > last)
+			std::swap(first, last);
 
-			input_ >> token;
-			if(token != "#")
+		switch(i % 5)
+		{
+			case 0:
+				sequence.insert_at(first, -i);
+				model.insert(model.begin() + first, -i);
+				break;
+			case 1:
+				sequence.reverse(first, last);
+				std::reverse(model.begin() + first, model.begin() + last);
+				break;
+			case 2:
+				sequence.add(first, last, i);
+				for(auto j = first; j < last; ++j)
+					model[j] += i;
+				break;
+			case 3:
+				sequence.erase_range(first, std::min(last, first + 10));
+				model.erase(model.begin() + first, model.begin() + std::min(last, first + 10));
+				break;
+			case 4:
 			{
-				DEBUG("Invalid token #1: " + token + ".");
-				return;
+				auto right = sequence.split_at(first);
+				res = res && sequence.size() == first && right.validate();
+				right.reverse(0, right.size());
+				right.concat(sequence);
+				sequence.concat(right);
+				res = res && right.empty();
+				std::rotate(model.begin(), model.begin() + first, model.end());
+				std::reverse(model.begin(), model.begin() + (size - first));
+				break;
 			}
+		}
 
-			while(input_  >> count)
-			{
-				DEBUG("Starting a new batch of " + std::to_string(count)
-					  + " instructions.");
+		if(!model.empty())
+			res = res && sequence.at((i * 31) % model.size()) == model[(i * 31) % model.size()];
+	}
 
-				tree_ = std::make_unique<SplayTree<T, SplayPolicy>>();
-				T key{};
-				for(std::size_t i = 0; i < count; ++i)
-				{
-					input_ >> token;
-					if(token == "I")
-					{
-						input_ >> key;
-						tree_->insert(key);
-					}
-					else
-					{
-						DEBUG("Only " + std::to_string(i + 1)
-							  + "inserts, expected " + std::to_string(count) + ".");
-						break;
-					}
-				}
+	std::vector<int> values{};
+	sequence.for_each([&](const int& value){ values.push_back(value); });
+	res = res && sequence.validate() && values == model;
 
-				std::size_t find_length{};
-				std::size_t find_count{};
-				while(input_ >> token && token == "F")
-				{
-					input_ >> key;
-					(void)tree_->find(key);
+	try
+	{
+		sequence.at(model.size());
+		res = false;
+	}
+	catch(std::out_of_range&)
+	{ /* DUMMY BODY */ }
 
-					++find_count;
-					find_length += tree_->length_of_last_find();
-				}
+	SplaySequence<std::string> strings{};
+	for(int i = 0; i < 100; ++i)
+		strings.push_back(std::to_string(i));
+	strings.reverse(10, 90);
+	strings.add(0, 1, "x");
+	res = res && strings.at(0) == "0x" && strings.at(10) == "89" && strings.at(89) == "10";
+	strings.clear();
+	res = res && strings.empty() && strings.validate();
 
-				if(find_count > 0)
-				{
-					auto average_length = find_length / find_count;
-					output_ << count << " " << average_length << std::endl;
-				}
-			}
-		}
+	if(!res)
+		TEST("Splay sequence failed.", 25);
+	return res;
+}
 
-	private:
-		/**
-		 * Tree used to accomplish the task.
-		 */
-		std::unique_ptr<SplayTree<T, SplayPolicy>> tree_;
+/**
+ * Returns the ancestors of a given vertex of a forest given by
+ * parent indices (-1 for roots), starting with the vertex.
+ */
+std::vector<int> ancestors(const std::vector<int>& parents, int vertex)
+{
+	std::vector<int> res{};
+	for(; vertex != -1; vertex = parents[vertex])
+		res.push_back(vertex);
+	return res;
+}
 
-		/**
-		 * Input file stream.
-		 */
-		std::ifstream input_;
+/**
+ * Test of the link-cut tree, checks it against a forest
+ * given by parent indices.
+ */
+bool test_26()
+{
+	int num{300};
+	LinkCutTree<int, ConcatenationAggregate> tree{};
+	LinkCutTree<int, SumAggregate<long long>> sums{};
+	std::vector<LinkCutTree<int, ConcatenationAggregate>::vertex> vertices{};
+	std::vector<LinkCutTree<int, SumAggregate<long long>>::vertex> sum_vertices{};
+	std::vector<int> parents(num, -1), values(num);
+	for(int i = 0; i < num; ++i)
+	{
+		values[i] = i * 3;
+		vertices.push_back(tree.add_vertex(values[i]));
+		sum_vertices.push_back(sums.add_vertex(values[i]));
+	}
 
-		/**
-		 * Output file stream.
-		 */
-		std::ofstream output_;
-};
+	bool res{tree.vertex_count() == static_cast<std::size_t>(num)};
+	for(int i = 0; i < 20 * num; ++i)
+	{
+		int u = (i * 7919) % num, v = (i * 104729 + 13) % num;
+		auto u_ancestors = ancestors(parents, u), v_ancestors = ancestors(parents, v);
+		bool connected{u_ancestors.back() == v_ancestors.back()};
+		res = res && tree.connected(vertices[u], vertices[v]) == connected;
 
-#if RUN_TESTS == 1
-void test();
-#endif
+		switch(i % 6)
+		{
+			case 0:
+			case 1:
+			{ // Rerooting at u reverses the parents on the path to its root.
+				res = res && tree.link(vertices[u], vertices[v]) == !connected;
+				sums.link(sum_vertices[u], sum_vertices[v]);
+				if(connected)
+					break;
+				for(std::size_t j = u_ancestors.size() - 1; j > 0; --j)
+					parents[u_ancestors[j]] = u_ancestors[j - 1];
+				parents[u] = v;
+				break;
+			}
+			case 2:
+			{
+				res = res && tree.cut(vertices[u]) == (parents[u] != -1);
+				sums.cut(sum_vertices[u]);
+				parents[u] = -1;
+				break;
+			}
+			case 3:
+			{
+				bool edge{parents[u] == v || parents[v] == u};
+				res = res && tree.cut(vertices[u], vertices[v]) == edge;
+				sums.cut(sum_vertices[u], sum_vertices[v]);
+				if(parents[u] == v)
+					parents[u] = -1;
+				else if(parents[v] == u)
+					parents[v] = -1;
+				break;
+			}
+			case 4:
+			{
+				values[u] = -i;
+				tree.set_value(vertices[u], values[u]);
+				sums.set_value(sum_vertices[u], values[u]);
+				break;
+			}
+			case 5:
+			{
+				auto root = tree.find_root(vertices[u]);
+				res = res && root == vertices[u_ancestors.back()];
+				auto parent = tree.parent(vertices[u]);
+				res = res && parent == (parents[u] == -1 ? nullptr : vertices[parents[u]]);
+				break;
+			}
+		}
 
-/**
- * Entry point of the program, executes tests
- * if needed and performs the task with both policies
- * on either a file given as the command line parameter
- * or the file "data.txt".
- */
-int main(int argc, char** argv)
-{
-#if RUN_TESTS == 1
-	test();
-#endif
-	std::string input{};
-	std::string output{};
+		u_ancestors = ancestors(parents, u), v_ancestors = ancestors(parents, v);
+		if(u_ancestors.back() != v_ancestors.back())
+		{
+			res = res && !tree.lca(vertices[u], vertices[v]);
+			continue;
+		}
 
-	if(argc > 1)
-		input = argv[1];
-	else
-		input = "data.txt";
-	output = input.substr(0, input.size() - 4) + ".out";
+		// The path goes up from u to the lca and down to v.
+		std::size_t u_depth = u_ancestors.size(), v_depth = v_ancestors.size();
+		while(u_depth > 1 && v_depth > 1
+			  && u_ancestors[u_depth - 2] == v_ancestors[v_depth - 2])
+			--u_depth, --v_depth;
+		int lca = u_ancestors[u_depth - 1];
+		res = res && tree.lca(vertices[u], vertices[v]) == vertices[lca];
 
-	do
-	{
-		Task<int, DoubleRotationSplayPolicy<int>> double_task{input, "double-" + output};
-		double_task.process();
+		std::string path{};
+		long long sum{};
+		for(std::size_t j = 0; j < u_depth; ++j)
+			path += std::to_string(values[u_ancestors[j]]) + ",", sum += values[u_ancestors[j]];
+		for(std::size_t j = v_depth - 1; j > 0; --j)
+			path += std::to_string(values[v_ancestors[j - 1]]) + ",", sum += values[v_ancestors[j - 1]];
+		res = res && tree.path_aggregate(vertices[u], vertices[v]) == path;
+		res = res && sums.path_aggregate(sum_vertices[u], sum_vertices[v]) == sum;
+		res = res && tree.find_root(vertices[v]) == vertices[v_ancestors.back()];
 	}
-	while(false);
 
-	do
+	try
 	{
-		Task<int, NaiveSplayPolicy<int>> naive_task{input, "naive-" + output};
-		naive_task.process();
+		auto lonely = tree.add_vertex(0);
+		tree.path_aggregate(vertices[0], lonely);
+		res = false;
 	}
-	while(false);
-};
+	catch(std::invalid_argument&)
+	{ /* DUMMY BODY */ }
 
-#if RUN_TESTS == 1
-bool test_1();
-bool test_2();
-bool test_3();
-bool test_4();
-bool test_5();
+	if(!res)
+		TEST("Link-cut tree failed.", 26);
+	return res;
+}
 
 /**
- * A simple test suite that ensured I didn't
- * break any functionality of the splay tree.
+ * Key that counts its copies.
  */
-void test()
+struct CopyCountingKey
 {
-	if(test_1())
-		TEST("Success.", 1);
-	else
-		TEST("Failure.", 1);
+	CopyCountingKey(int v)
+		: value{v}
+	{ /* DUMMY BODY */ }
 
-	if(test_2())
-		TEST("Success.", 2);
-	else
-		TEST("Failure.", 2);
+	CopyCountingKey(const CopyCountingKey& other)
+		: value{other.value}
+	{
+		++copies;
+	}
 
-	if(test_3())
-		TEST("Success.", 3);
-	else
-		TEST("Failure.", 3);
+	CopyCountingKey(CopyCountingKey&&) = default;
+	CopyCountingKey& operator=(const CopyCountingKey&) = default;
+	CopyCountingKey& operator=(CopyCountingKey&&) = default;
 
-	if(test_4())
-		TEST("Success.", 4);
-	else
-		TEST("Failure.", 4);
+	friend bool operator<(const CopyCountingKey& a, const CopyCountingKey& b)
+	{
+		return a.value < b.value;
+	}
 
-	if(test_5())
-		TEST("Success.", 5);
-	else
-		TEST("Failure.", 5);
-}
+	int value;
+
+	static inline std::size_t copies{};
+};
 
 /**
- * Test of the left rotation on a small input.
+ * Checks moves, clones and in-place inserts of
+ * trees with a given policy and node template.
  */
-bool test_1()
+template<typename SplayPolicy, template<typename, bool> class NodeTemplate = Node>
+bool test_moves(int num)
 {
-	/**
-	 * Nodes are statically allocated to
-	 * use RAII.
-	 */
-	Node<int> node_1{1};
-	Node<int> node_2{2};
-	Node<int> node_3{3};
-	Node<int> node_4{4};
-	Node<int> node_5{5};
-
-	/**
-	 * Building the tree for rotation:
-	 *     1          2
-	 *    / \        / \
-	 *   2  3   =>  1   5
-	 *     / \     / \
-	 *    4   5   3   4
-	 */
-	Node<int>* root{&node_1};
-	root->left = &node_2;
-	root->right = &node_3;
-	root->right->left = &node_4;
-	root->right->right = &node_5;
-
-	SplayTreeRotator<int>::rotate_left(root, &root);
+	using Tree = SplayTree<
+		CopyCountingKey, SplayPolicy, utils::SplayComparator<CopyCountingKey>,
+		SlabAllocator, NoSplayStatistics, NodeTemplate
+	>;
 
-	bool res_root{root == &node_3};
-	bool res_left{root->left == &node_1};
-	bool res_left_left{root->left->left == &node_2};
-	bool res_left_right{root->left->right == &node_4};
-	bool res_right{root->right == &node_5};
-	
-	if(!res_root)
+	CopyCountingKey::copies = 0;
+	Tree tree{};
+	for(int i = 0; i < num; ++i)
 	{
-		TEST("New root is incorrect: " + std::to_string(root->key)
-			 + " != 3.", 1);
+		tree.insert(CopyCountingKey{(i * 7919) % num});
+		tree.emplace((i * 104729) % num);
 	}
+	bool res{CopyCountingKey::copies == 0 && tree.size() == static_cast<std::size_t>(num)};
 
-	if(!res_left)
-	{
-		TEST("Left child of root is incorrect: "
-			 + std::to_string(root->left->key) + " != 1.", 2);
-	}
+	Tree moved{std::move(tree)};
+	res = res && tree.size() == 0 && moved.size() == static_cast<std::size_t>(num);
+	res = res && moved.validate() && CopyCountingKey::copies == 0;
 
-	if(!res_left_left)
-	{
-		TEST("Left-left grandchild of root is incorrect: "
-			 + std::to_string(root->left->left->key) + " != 2.", 2);
+	auto copy = moved.clone();
+	res = res && CopyCountingKey::copies == static_cast<std::size_t>(num);
+	res = res && copy.validate();
+	for(int i = 0; i < num; i += 7)
+	{ // Same shapes splay the same way.
+		res = res && copy.contains(CopyCountingKey{i}) && moved.contains(CopyCountingKey{i});
+		res = res && copy.length_of_last_find() == moved.length_of_last_find();
 	}
+	for(int i = 0; i < num; i += 2)
+		copy.erase(CopyCountingKey{i});
+	res = res && copy.size() == static_cast<std::size_t>(num / 2);
+	res = res && moved.size() == static_cast<std::size_t>(num) && moved.validate();
 
-	if(!res_left_right)
-	{
-		TEST("Left-right grandchild of root is incorrect: "
-			 + std::to_string(root->left->right->key) + " != 4.", 2);
-	}
+	// Both trees stay usable after the moves.
+	tree.insert(CopyCountingKey{num});
+	tree = std::move(copy);
+	copy.emplace(num);
+	res = res && tree.size() == static_cast<std::size_t>(num / 2) && tree.validate();
+	res = res && copy.size() == 1 && copy.contains(CopyCountingKey{num});
+	res = res && !tree.contains(CopyCountingKey{0}) && tree.contains(CopyCountingKey{1});
 
-	if(!res_right)
+	std::vector<Tree> trees{};
+	for(int i = 0; i < 10; ++i)
 	{
-		TEST("Right child of root is incorrect: "
-			 + std::to_string(root->right->key) + " != 5.", 2);
+		trees.emplace_back();
+		trees.back().emplace(i);
 	}
+	for(int i = 0; i < 10; ++i)
+		res = res && trees[i].size() == 1 && trees[i].contains(CopyCountingKey{i});
 
-	return res_root && res_left && res_left_left
-		   && res_left_right && res_right;
+	return res;
 }
 
 /**
- * Test of the right rotation on a small input.
+ * Test of moves, clones and in-place inserts.
  */
-bool test_2()
+bool test_27()
 {
-	/**
-	 * Nodes are statically allocated to
-	 * use RAII.
-	 */
-	Node<int> node_1{1};
-	Node<int> node_2{2};
-	Node<int> node_3{3};
-	Node<int> node_4{4};
-	Node<int> node_5{5};
-
-	/**
-	 * Building the tree for rotation:
-	 *     1          2
-	 *    / \        / \
-	 *   2  3   =>  4   1
-	 *  / \            / \
-	 *  4  5          5   3
-	 */
-	Node<int>* root{&node_1};
-	root->left = &node_2;
-	root->right = &node_3;
-	root->left->left = &node_4;
-	root->left->right = &node_5;
+	bool res{true};
+	res = res && test_moves<DoubleRotationSplayPolicy<CopyCountingKey>>(1000);
+	res = res && test_moves<TopDownSplayPolicy<CopyCountingKey>>(1000);
+	res = res && test_moves<NaiveSplayPolicy<CopyCountingKey>, SizedNode>(1000);
 
-	SplayTreeRotator<int>::rotate_right(root, &root);
+	SplayTree<std::string, DoubleRotationSplayPolicy<std::string>> strings{};
+	strings.emplace(5, 'x');
+	strings.insert(std::string(20, 'y'));
+	res = res && strings.contains(std::string_view{"xxxxx"}) && strings.size() == 2;
 
-	bool res_root{root == &node_2};
-	bool res_left{root->left == &node_4};
-	bool res_right_left{root->right->left == &node_5};
-	bool res_right_right{root->right->right == &node_3};
-	bool res_right{root->right == &node_1};
-	
-	if(!res_root)
+	// Clones continue the random sequence of the original.
+	SplayTree<int, ProbabilisticSplayPolicy<int>> random{};
+	for(int i = 1; i <= 1000; ++i)
+		random.insert(i * 37 % 1000);
+	for(int i = 1; i <= 100; ++i)
+		random.find(i * 101 % 1000);
+	auto random_copy = random.clone();
+	for(int i = 1; i <= 1000; ++i)
 	{
-		TEST("New root is incorrect: " + std::to_string(root->key)
-			 + " != 3.", 1);
+		random.find(i * 211 % 1000);
+		random_copy.find(i * 211 % 1000);
+		res = res && random.length_of_last_find() == random_copy.length_of_last_find();
 	}
 
-	if(!res_left)
+	if(!res)
+		TEST("Moves, clones or in-place inserts failed.", 27);
+	return res;
+}
+
+/**
+ * Key that counts its live instances.
+ */
+struct LiveCountingKey
+{
+	LiveCountingKey(int v)
+		: value{v}
 	{
-		TEST("Left child of root is incorrect: "
-			 + std::to_string(root->left->key) + " != 4.", 1);
+		++live;
 	}
 
-	if(!res_right_left)
+	LiveCountingKey(const LiveCountingKey& other)
+		: value{other.value}
 	{
-		TEST("Left-left grandchild of root is incorrect: "
-			 + std::to_string(root->right->left->key) + " != 5.", 1);
+		++live;
 	}
 
-	if(!res_right_right)
+	~LiveCountingKey()
 	{
-		TEST("Left-right grandchild of root is incorrect: "
-			 + std::to_string(root->right->right->key) + " != 3.", 1);
+		--live;
 	}
 
-	if(!res_right)
+	LiveCountingKey& operator=(const LiveCountingKey&) = default;
+
+	friend bool operator<(const LiveCountingKey& a, const LiveCountingKey& b)
 	{
-		TEST("Right child of root is incorrect: "
-			 + std::to_string(root->right->key) + " != 1.", 1);
+		return a.value < b.value;
 	}
 
-	return res_root && res_left && res_right_left
-		   && res_right_right && res_right;
-}
+	int value;
+
+	static inline int live{};
+};
 
 /**
- * Simple test that checks that both contains and
- * find functions work correctly and also checks if
- * insert builds a correct binary search tree.
- * NOTE: Double rotation version.
+ * Checks that trees using a given allocator destroy all
+ * of their keys when cleared and when destroyed.
  */
-bool test_3()
+template<template<typename> class Allocator>
+bool test_allocator_destruction(int num)
 {
-	SplayTree<int, DoubleRotationSplayPolicy<int>> tree{};
-	int test_data[] { 4, 3, 2, 1, 6, 7, 8, 5};
-
-	for(auto data : test_data)
-	{
-		tree.insert(data);
-		tree.print();
-	}
-	if(!tree.validate())
-		TEST("Tree invalid.", 3);
+	using Tree = SplayTree<
+		LiveCountingKey, DoubleRotationSplayPolicy<LiveCountingKey>,
+		utils::SplayComparator<LiveCountingKey>, Allocator
+	>;
 
 	bool res{true};
-	for(auto data : test_data)
 	{
-		if(!tree.contains(data))
-		{
-			TEST("Tree does not contain key: " + std::to_string(data)
-				 + ".", 3);
-			res = false;
-		}
-	}
+		Tree tree{};
+		for(int i = 0; i < num; ++i)
+			tree.insert(LiveCountingKey{(i * 7919) % num});
+		res = res && LiveCountingKey::live == num;
 
-	for(auto data : test_data)
-	{
-		if(tree.find(data) != data)
-		{
-			TEST("Tree find failed: " + std::to_string(data)
-				 + " != " + std::to_string(data) + ".", 3);
-			res = false;
-		}
+		for(int i = 0; i < num; i += 2)
+			tree.erase(LiveCountingKey{i});
+		res = res && LiveCountingKey::live == num / 2;
+
+		tree.clear();
+		res = res && LiveCountingKey::live == 0;
+
+		for(int i = 0; i < num; ++i)
+			tree.insert(LiveCountingKey{i});
 	}
 
-	return res;
+	return res && LiveCountingKey::live == 0;
 }
 
 /**
- * Simple test that checks that both contains and
- * find functions work correctly and also checks if
- * insert builds a correct binary search tree.
- * NOTE: Naive version.
+ * Test of the node allocators, checks the reuse of nodes by
+ * the slab allocator and both destruction paths of the trees.
  */
-bool test_4()
+bool test_28()
 {
-	SplayTree<int, NaiveSplayPolicy<int>> tree{};
-	int test_data[] { 4, 3, 2, 1, 6, 7, 8, 5};
+	bool res{true};
 
-	for(auto data : test_data)
-		tree.insert(data);
-	if(!tree.validate())
-		TEST("Tree invalid.", 4);
+	SlabAllocator<Node<int>> slab{};
+	auto first = slab.allocate(1);
+	auto second = slab.allocate(2);
+	res = res && reinterpret_cast<std::uintptr_t>(second)
+				 == reinterpret_cast<std::uintptr_t>(first) + sizeof(Node<int>);
 
-	bool res{true};
-	for(auto data : test_data)
+	// Deallocated nodes are reused first, reset reuses the whole slab.
+	slab.deallocate(first);
+	auto reused = slab.allocate(3);
+	res = res && reused == first && reused->key == 3 && second->key == 2;
+	slab.reset();
+	res = res && slab.allocate(4) == first && slab.allocate(5) == second;
+
+	NewDeleteAllocator<Node<int>> heap{};
+	auto node = heap.allocate(6);
+	res = res && node->key == 6 && !node->left && !node->right;
+	heap.deallocate(node);
+
+	// Trees of trivially destructible keys are freed in bulk,
+	// the others are walked so that every key is destroyed.
+	static_assert(SlabAllocator<Node<int>>::releases_in_bulk);
+	static_assert(!NewDeleteAllocator<Node<int>>::releases_in_bulk);
+	res = res && test_allocator_destruction<SlabAllocator>(1000);
+	res = res && test_allocator_destruction<NewDeleteAllocator>(1000);
 	{
-		if(!tree.contains(data))
+		SplayTree<int, DoubleRotationSplayPolicy<int>> tree{};
+		for(int i = 0; i < 1000; ++i)
+			tree.insert((i * 7919) % 1000);
+		tree.clear();
+		for(int i = 0; i < 1000; ++i)
+			tree.insert(i);
+		res = res && tree.size() == 1000 && tree.validate();
+
+		// Split trees share the arena, join of trees of different
+		// arenas merges them.
+		for(int i = 0; i < 100; ++i)
 		{
-			TEST("Tree does not contain key: " + std::to_string(data)
-				 + ".", 4);
-			res = false;
+			auto right = tree.split((i * 7919) % 1000);
+			tree.join(right);
 		}
-	}
+		{
+			auto right = tree.split(500);
+			res = res && tree.size() == 500;
+		}
+		for(int i = 500; i < 1000; ++i)
+			tree.insert(i);
+		SplayTree<int, DoubleRotationSplayPolicy<int>> other{};
+		for(int i = 1000; i < 2000; ++i)
+			other.insert(i);
+		tree.join(other);
+		res = res && tree.size() == 2000 && tree.validate();
 
-	for(auto data : test_data)
-	{
-		if(tree.find(data) != data)
+		// Overlapping trees are not joined.
+		SplayTree<int, DoubleRotationSplayPolicy<int>> overlapping{};
+		overlapping.insert(1999);
+		overlapping.insert(3000);
+		try
 		{
-			TEST("Tree find failed: " + std::to_string(data)
-				 + " != " + std::to_string(data) + ".", 4);
+			tree.join(overlapping);
 			res = false;
 		}
+		catch(std::invalid_argument&)
+		{ /* DUMMY BODY */ }
+		res = res && tree.size() == 2000 && overlapping.size() == 2
+				  && tree.validate() && overlapping.validate() && overlapping.contains(1999);
 	}
 
-	return res;
-}
-
-/**
- *
- */
-bool test_5()
-{
-	std::string test_file{"test_x_a_b_11-_2444-_aafa.txt"};
-	std::ofstream output{test_file};
-	output << "# 3\nI 1\nI 2\nI 0\nF 1\nF 0\nF 2" << std::endl;
-
-	Task<int, DoubleRotationSplayPolicy<int>> task1{test_file};
-	task1.process();
-
-	std::remove(test_file.c_str());
+	// Nodes of a destroyed allocator sharing the arena are reused
+	// once the rest of the first slab (64 nodes) is used.
+	SlabAllocator<Node<int>> left{};
+	left.allocate(0);
+	Node<int>* given{};
+	{
+		SlabAllocator<Node<int>> right{left};
+		res = res && !left.exclusive();
+		given = right.allocate(1);
+		right.deallocate(given);
+	}
+	res = res && left.exclusive();
+	for(int i = 1; i < 64; ++i)
+		left.allocate(i);
+	res = res && left.allocate(64) == given;
 
-	return true;
+	if(!res)
+		TEST("Allocators failed.", 28);
+	return res;
 }
 #endif